@@ -1,22 +1,51 @@
-QT += core gui widgets printsupport
+QT += core gui widgets printsupport concurrent
 
-CONFIG += console
+CONFIG += console thread
 CONFIG -= app_bundle
 QMAKE_CXXFLAGS += -std=c++17
 
+# qmake CONFIG+=compact_storage: float edge weights and vertex coordinates
+compact_storage: DEFINES += EULER_COMPACT_STORAGE
+# qmake CONFIG+=avx2: build everything for AVX2 CPUs (the all-pairs kernel
+# already switches to AVX2 at run time without it)
+avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2
+}
+
 TEMPLATE = app
 
 SOURCES += \
     src/main.cpp \
     src/Algorithms.cpp \
+    src/AllPairs.cpp \
     src/Graph.cpp \
+    src/GraphBuilder.cpp \
+    src/GraphIO.cpp \
     src/GraphCanvas.cpp \
     src/MainWindow.cpp \
-    src/ChinesePostman.cpp
+    src/ChinesePostman.cpp \
+    src/ContractionHierarchy.cpp \
+    src/CsrGraph.cpp \
+    src/Matching.cpp \
+    src/ShortestPath.cpp \
+    src/StrongComponents.cpp \
+    src/ThreadPool.cpp \
+    src/UnionFind.cpp
 
 HEADERS += \
     src/Algorithms.h \
+    src/AllPairs.h \
     src/Graph.h \
+    src/GraphBuilder.h \
+    src/GraphIO.h \
     src/GraphCanvas.h \
     src/MainWindow.h \
-    src/ChinesePostman.h
+    src/ChinesePostman.h \
+    src/ContractionHierarchy.h \
+    src/CsrGraph.h \
+    src/Matching.h \
+    src/ShortestPath.h \
+    src/StrongComponents.h \
+    src/ThreadPool.h \
+    src/UnionFind.h
@@ -1,10 +1,10 @@
 #include "Algorithms.h"
-#include <queue>
+#include "ContractionHierarchy.h"
+#include "CsrGraph.h"
+#include "ShortestPath.h"
 #include <limits>
 #include <algorithm>
 #include <unordered_map>
-#include <unordered_set>
-#include <functional>
 
 using namespace std;
 
@@ -18,21 +18,21 @@ namespace {
 struct EdgeUse { int id; bool used{false}; };
 
 bool isEulerianOrSemi(const Graph &g, bool &isCycle, int &startVertex) {
+    // parity is maintained by Graph, so reject on the odd count before any traversal
+    const vector<int> &odd = g.oddVertices();
+    if (odd.size() != 0 && odd.size() != 2) return false;
     if (!g.isConnectedUndirected()) return false;
-    int oddCount = 0;
     startVertex = 0;
-    for (const auto &v : g.getVertices()) {
-        int d = g.degree(v.id);
-        if (d % 2 == 1) {
-            oddCount++;
-            startVertex = v.id;
-        } else if (startVertex == 0 && d > 0) {
-            startVertex = v.id;
-        }
+    if (odd.size() == 2) {
+        startVertex = max(odd[0], odd[1]);
+        isCycle = false;
+        return true;
     }
-    if (oddCount == 0) { isCycle = true; return true; }
-    if (oddCount == 2) { isCycle = false; return true; }
-    return false;
+    // a circuit may start at any vertex that has an edge
+    auto live = g.liveEdges();
+    if (live.begin() != live.end()) startVertex = live.begin()->u;
+    isCycle = true;
+    return true;
 }
 }
 
@@ -43,49 +43,11 @@ optional<EulerResult> Algorithms::findEulerTourHierholzer(const Graph &graph) {
         return nullopt;
     }
 
-    // Build adjacency list and edge usage tracking
-    unordered_map<int, vector<int>> adj = graph.adjacency();
-    vector<bool> edgeUsed(graph.getEdges().size(), false);
-    vector<int> path; // Final path as edge IDs
-    
-    // DFS function to find Euler path/cycle
-    function<void(int)> dfs = [&](int u) {
-        auto it = adj.find(u);
-        if (it == adj.end()) return;
-        
-        // Create a copy of edges to iterate through
-        vector<int> edges = it->second;
-        for (int eid : edges) {
-            if (!edgeUsed[eid]) {
-                edgeUsed[eid] = true;
-                const Edge &e = graph.getEdges()[eid];
-                int v = (e.u == u) ? e.v : e.u;
-                dfs(v);
-                path.push_back(eid);
-            }
-        }
-    };
-    
-    // Start DFS from the starting vertex
-    dfs(start);
-    
-    // Reverse to get correct order
-    reverse(path.begin(), path.end());
-    
-    // Verify all edges are used exactly once
-    for (int i = 0; i < (int)graph.getEdges().size(); ++i) {
-        if (!edgeUsed[i]) {
-            return nullopt; // Some edges weren't used
-        }
-    }
-    
-    // Additional verification: check that each edge appears exactly once in path
-    vector<int> edgeCount(graph.getEdges().size(), 0);
-    for (int eid : path) {
-        edgeCount[eid]++;
-        if (edgeCount[eid] > 1) {
-            return nullopt; // Edge used more than once
-        }
+    vector<int> path = eulerEdgeOrder(graph.csr(), (int)graph.getEdges().size(), start);
+
+    // Every live edge must be used exactly once (the walk never reuses an edge)
+    if (static_cast<int>(path.size()) != graph.edgeCount()) {
+        return nullopt; // Some edges weren't used
     }
     
     EulerResult res;
@@ -96,35 +58,72 @@ optional<EulerResult> Algorithms::findEulerTourHierholzer(const Graph &graph) {
     return detail::lastEulerResult;
 }
 
-vector<int> Algorithms::shortestPathVertices(const Graph &graph, int source, int target) {
-    const int n = (int)graph.getVertices().size();
-    vector<double> dist(n, numeric_limits<double>::infinity());
-    vector<int> parent(n, -1);
-    using QN = pair<double,int>;
-    priority_queue<QN, vector<QN>, greater<QN>> pq;
-    dist[source] = 0.0; pq.push({0.0, source});
-    unordered_map<int, vector<int>> v2e = graph.adjacency();
-
-    while (!pq.empty()) {
-        auto [d, u] = pq.top(); pq.pop();
-        if (d != dist[u]) continue;
-        if (u == target) break;
-        auto it = v2e.find(u);
-        if (it == v2e.end()) continue;
-        for (int eid : it->second) {
-            const Edge &e = graph.getEdges()[eid];
-            int w = (e.u == u ? e.v : e.u);
-            double nd = d + e.weight;
-            if (nd < dist[w]) { dist[w] = nd; parent[w] = u; pq.push({nd, w}); }
+vector<int> Algorithms::eulerEdgeOrder(const CsrGraph &csr, int edgeCount, int start) {
+    vector<int> path; // edge ids, in reverse walk order until the final reverse
+    if (start < 0 || start >= csr.vertexCount()) return path;
+
+    vector<int> cursor(csr.vertexCount());
+    for (int u = 0; u < csr.vertexCount(); ++u) cursor[u] = csr.arcBegin(u);
+    vector<char> edgeUsed(edgeCount, 0);
+
+    // Explicit DFS stack of (vertex, edge id used to reach it)
+    vector<pair<int,int>> stack;
+    stack.reserve(static_cast<size_t>(edgeCount) + 1);
+    path.reserve(edgeCount);
+    stack.push_back({start, -1});
+    while (!stack.empty()) {
+        int u = stack.back().first;
+        int &a = cursor[u];
+        while (a < csr.arcEnd(u) && edgeUsed[csr.edgeId(a)]) ++a;
+        if (a == csr.arcEnd(u)) {
+            // dead end: emit the edge we arrived by and backtrack
+            int eid = stack.back().second;
+            stack.pop_back();
+            if (eid >= 0) path.push_back(eid);
+        } else {
+            int eid = csr.edgeId(a);
+            edgeUsed[eid] = 1;
+            stack.push_back({csr.target(a), eid});
+            ++a;
         }
     }
-    vector<int> path;
-    if (parent[target] == -1 && source != target) return path;
-    for (int v = target; v != -1; v = parent[v]) path.push_back(v);
     reverse(path.begin(), path.end());
     return path;
 }
 
+// Non-default engines; an attached hierarchy is queried directly, skipping the
+// O(E) heuristic calibration of a fresh PointToPoint searcher
+static ShortestPath::Route pointToPointRoute(const Graph &graph, int source, int target, ShortestPath::Engine engine) {
+    const ContractionHierarchy *ch = graph.contractionHierarchy();
+    if (engine == ShortestPath::Engine::Hierarchy && ch) return ch->route(source, target);
+    return ShortestPath::PointToPoint(graph).query(source, target, engine);
+}
+
+vector<int> Algorithms::shortestPathEdges(const Graph &graph, int source, int target, ShortestPath::Engine engine) {
+    if (engine != ShortestPath::Engine::Dijkstra)
+        return pointToPointRoute(graph, source, target, engine).edges;
+    ShortestPath::Workspace ws;
+    ShortestPath::dijkstra(graph.csr(), source, ws, target);
+    return ShortestPath::pathEdges(ws.predEdge, graph.getEdges(), source, target);
+}
+
+vector<int> Algorithms::shortestPathVertices(const Graph &graph, int source, int target, ShortestPath::Engine engine) {
+    if (engine != ShortestPath::Engine::Dijkstra) {
+        ShortestPath::Route r = pointToPointRoute(graph, source, target, engine);
+        if (r.length == numeric_limits<double>::infinity()) return {};
+        const auto &edges = graph.getEdges();
+        vector<int> path{source};
+        for (int id : r.edges) {
+            const Edge &e = edges[id];
+            path.push_back(e.u == path.back() ? e.v : e.u);
+        }
+        return path;
+    }
+    ShortestPath::Workspace ws;
+    ShortestPath::dijkstra(graph.csr(), source, ws, target);
+    return ShortestPath::pathVertices(ws.predEdge, graph.getEdges(), source, target);
+}
+
 optional<EulerResult> Algorithms::approximateChinesePostman(const Graph &graph) {
     bool cycle = false; int start = 0;
     if (isEulerianOrSemi(graph, cycle, start) && cycle) {
@@ -134,17 +133,17 @@ optional<EulerResult> Algorithms::approximateChinesePostman(const Graph &graph)
     }
 
     // Collect odd-degree vertices
-    vector<int> odd;
-    for (const auto &v : graph.getVertices()) {
-        if (graph.degree(v.id) % 2 == 1) odd.push_back(v.id);
-    }
+    vector<int> odd = graph.oddVertices();
+    sort(odd.begin(), odd.end());
     if (odd.empty()) return findEulerTourHierholzer(graph);
 
-    // Greedy pairing: repeatedly pair closest odd vertices by shortest path length
-    vector<bool> used(graph.getVertices().size(), false);
+    // Greedy pairing: repeatedly pair closest odd vertices by shortest path length.
+    // The oracle runs one Dijkstra per source and answers every later distance and
+    // path query for it from cache, so the whole heuristic costs O(k) searches.
+    ShortestPath::DistanceOracle oracle(graph);
     vector<pair<int,int>> pairs;
-    unordered_set<int> oddSet(odd.begin(), odd.end());
 
+    const auto &edges = graph.getEdges();
     vector<int> remaining = odd;
     while (!remaining.empty()) {
         int a = remaining.back(); remaining.pop_back();
@@ -152,21 +151,7 @@ optional<EulerResult> Algorithms::approximateChinesePostman(const Graph &graph)
         int bestIdx = -1; int bestV = -1;
         for (int i = 0; i < (int)remaining.size(); ++i) {
             int b = remaining[i];
-            auto path = shortestPathVertices(graph, a, b);
-            if (path.empty()) continue;
-            double len = 0.0;
-            for (size_t k = 1; k < path.size(); ++k) {
-                // sum weights along edges
-                // find edge between path[k-1], path[k]
-                int u = path[k-1], v = path[k];
-                double w = numeric_limits<double>::infinity();
-                for (int eid : graph.adjacency().at(u)) {
-                    const Edge &e = graph.getEdges()[eid];
-                    int wv = (e.u == u ? e.v : e.u);
-                    if (wv == v) { w = e.weight; break; }
-                }
-                len += w;
-            }
+            double len = oracle.distance(a, b);
             if (len < best) { best = len; bestIdx = i; bestV = b; }
         }
         if (bestIdx == -1) break;
@@ -177,19 +162,10 @@ optional<EulerResult> Algorithms::approximateChinesePostman(const Graph &graph)
     // Build a multigraph by duplicating edges along these shortest paths
     Graph augmented = graph;
     for (auto [a, b] : pairs) {
-        auto path = shortestPathVertices(graph, a, b);
-        for (size_t k = 1; k < path.size(); ++k) {
-            int u = path[k-1], v = path[k];
-            // find a representative edge and duplicate it in augmented
-            int representative = -1; double w = 1.0;
-            for (int eid : graph.adjacency().at(u)) {
-                const Edge &e = graph.getEdges()[eid];
-                int wv = (e.u == u ? e.v : e.u);
-                if (wv == v) { representative = eid; w = e.weight; break; }
-            }
-            if (representative != -1) {
-                augmented.addEdge(u, v, w, false);
-            }
+        // duplicate each edge of the path with its true weight
+        for (int eid : oracle.route(a, b).edges) {
+            const Edge &e = edges[eid];
+            augmented.addEdge(e.u, e.v, e.weight, false, DuplicateEdgePolicy::AllowMulti);
         }
     }
 
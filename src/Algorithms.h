@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Graph.h"
+#include "ShortestPath.h"
 #include <vector>
 #include <optional>
 
@@ -21,11 +22,20 @@ namespace detail {
 // Returns nullopt if no Euler path/cycle exists
 std::optional<EulerResult> findEulerTourHierholzer(const Graph &graph);
 
+// Iterative Hierholzer over a CSR view, O(V+E) with one "next unused arc" cursor
+// per vertex. Returns the edge ids of the walk from start (edge ids < edgeCount).
+std::vector<int> eulerEdgeOrder(const CsrGraph &csr, int edgeCount, int start);
+
 // For Chinese Postman
 std::optional<EulerResult> approximateChinesePostman(const Graph &graph);
 
 // Utility shortest path
-std::vector<int> shortestPathVertices(const Graph &graph, int source, int target);
+// engine picks the point-to-point search; all engines return a shortest path
+std::vector<int> shortestPathVertices(const Graph &graph, int source, int target,
+                                      ShortestPath::Engine engine = ShortestPath::Engine::Dijkstra);
+// Same path as edge ids in travel order (follows recorded predecessor edges)
+std::vector<int> shortestPathEdges(const Graph &graph, int source, int target,
+                                   ShortestPath::Engine engine = ShortestPath::Engine::Dijkstra);
 
 // Summary access
 std::optional<EulerResult> getEulerSummary();
@@ -0,0 +1,183 @@
+#include "AllPairs.h"
+#include "CsrGraph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+// The AVX2 tile kernel is compiled in even without -mavx2 where the compiler
+// allows per-function targets, and picked at run time from the CPU flags.
+#if defined(__AVX2__)
+#define ALLPAIRS_AVX2 1
+#define ALLPAIRS_AVX2_TARGET
+#include <immintrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ALLPAIRS_AVX2 1
+#define ALLPAIRS_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define ALLPAIRS_AVX2 1
+#define ALLPAIRS_AVX2_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+const double kInf = numeric_limits<double>::infinity();
+// V^2 doubles: 2048 vertices already take 32 MiB
+constexpr int kMaxVertices = 2048;
+// Rough cost of one min-plus step relative to one heap operation of a search
+// (a vectorized step is several times cheaper than a scalar one, and a heap
+// operation costs a few cache misses), and of a bucket-queue search (integer
+// weights) relative to a heap search. They only need to be right within a
+// small factor, as the two sides usually differ by far more.
+constexpr double kFloydStepCostAvx2 = 0.5;
+constexpr double kFloydStepCostScalar = 2.0;
+constexpr double kBucketSearchCost = 0.25;
+
+constexpr int kBlock = AllPairs::DistanceMatrix::kBlock;
+
+// C[i][j] = min(C[i][j], A[i][k] + B[k][j]) over one kBlock x kBlock tile
+// whose rows are s doubles apart.
+void relaxTileScalar(double *C, const double *A, const double *B, size_t s) {
+    for (int k = 0; k < kBlock; ++k) {
+        const double *bk = B + k * s;
+        for (int i = 0; i < kBlock; ++i) {
+            const double aik = A[i * s + k];
+            if (aik == kInf) continue;
+            double *ci = C + i * s;
+            for (int j = 0; j < kBlock; ++j) {
+                const double via = aik + bk[j];
+                ci[j] = via < ci[j] ? via : ci[j];
+            }
+        }
+    }
+}
+
+#if defined(ALLPAIRS_AVX2)
+ALLPAIRS_AVX2_TARGET void relaxTileAvx2(double *C, const double *A, const double *B, size_t s) {
+    for (int k = 0; k < kBlock; ++k) {
+        const double *bk = B + k * s;
+        for (int i = 0; i < kBlock; ++i) {
+            const double aik = A[i * s + k];
+            if (aik == kInf) continue;
+            double *ci = C + i * s;
+            const __m256d a = _mm256_set1_pd(aik);
+            for (int j = 0; j < kBlock; j += 4) {
+                const __m256d via = _mm256_add_pd(a, _mm256_loadu_pd(bk + j));
+                _mm256_storeu_pd(ci + j, _mm256_min_pd(via, _mm256_loadu_pd(ci + j)));
+            }
+        }
+    }
+}
+#endif
+
+bool cpuHasAvx2() {
+#if defined(__AVX2__)
+    return true;
+#elif defined(ALLPAIRS_AVX2) && defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    const bool osSavesYmm = (r[2] & (1 << 27)) && (r[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    if (!osSavesYmm) return false;
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#elif defined(ALLPAIRS_AVX2)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Checked once; the answer cannot change while the process runs.
+bool useAvx2() {
+    static const bool avx2 = cpuHasAvx2();
+    return avx2;
+}
+}
+
+AllPairs::DistanceMatrix::DistanceMatrix(const CsrGraph &g) : n(g.vertexCount()) {
+    const int tiles = (n + kBlock - 1) / kBlock;
+    stride = tiles * kBlock;
+    d.assign(static_cast<size_t>(stride) * stride, kInf);
+    for (int u = 0; u < n; ++u) {
+        double *row = &d[static_cast<size_t>(u) * stride];
+        row[u] = 0.0;
+        for (int a = g.arcBegin(u); a < g.arcEnd(u); ++a) row[g.target(a)] = min(row[g.target(a)], g.weight(a));
+    }
+
+    ThreadPool &pool = ThreadPool::shared();
+    for (int kb = 0; kb < tiles; ++kb) {
+        relaxTile(kb, kb, kb);
+        // the pivot row and column only depend on the diagonal tile
+        pool.parallelFor(2 * tiles, [&](int t, int) {
+            const int other = t / 2;
+            if (other == kb) return;
+            if (t % 2 == 0) relaxTile(kb, other, kb);
+            else relaxTile(other, kb, kb);
+        });
+        // every remaining tile only depends on the pivot row and column
+        pool.parallelFor(tiles * tiles, [&](int t, int) {
+            const int ib = t / tiles, jb = t % tiles;
+            if (ib == kb || jb == kb) return;
+            relaxTile(ib, jb, kb);
+        });
+    }
+}
+
+void AllPairs::DistanceMatrix::relaxTile(int ib, int jb, int kb) {
+    // C[i][j] = min(C[i][j], A[i][k] + B[k][j]) with C = (ib, jb), A = (ib, kb),
+    // B = (kb, jb). Tiles may alias: d[k][k] = 0 keeps row and column k fixed
+    // during step k, exactly as in the unblocked algorithm.
+    const size_t s = static_cast<size_t>(stride);
+    double *C = &d[static_cast<size_t>(ib) * kBlock * s + static_cast<size_t>(jb) * kBlock];
+    const double *A = &d[static_cast<size_t>(ib) * kBlock * s + static_cast<size_t>(kb) * kBlock];
+    const double *B = &d[static_cast<size_t>(kb) * kBlock * s + static_cast<size_t>(jb) * kBlock];
+#if defined(ALLPAIRS_AVX2)
+    if (useAvx2()) {
+        relaxTileAvx2(C, A, B, s);
+        return;
+    }
+#endif
+    relaxTileScalar(C, A, B, s);
+}
+
+vector<int> AllPairs::DistanceMatrix::pathEdges(const CsrGraph &g, int u, int v) const {
+    if (u < 0 || v < 0 || u >= n || v >= n || u == v || at(u, v) == kInf) return {};
+    // Breadth-first search over the tight arcs only, i.e. those lying on some
+    // shortest path to v. A greedy walk would do in most graphs, but zero-weight
+    // edges make whole groups of vertices tie and it can wander in circles.
+    vector<int> from(n, -1), viaArc(n, -1);
+    vector<int> frontier{u};
+    from[u] = u;
+    for (size_t head = 0; head < frontier.size() && from[v] < 0; ++head) {
+        const int x = frontier[head];
+        const double remaining = at(x, v);
+        // the sums were formed in a different order than the matrix entries
+        const double slack = 1e-9 * max(1.0, remaining);
+        for (int a = g.arcBegin(x); a < g.arcEnd(x); ++a) {
+            const int y = g.target(a);
+            if (from[y] >= 0 || g.weight(a) + at(y, v) > remaining + slack) continue;
+            from[y] = x;
+            viaArc[y] = a;
+            frontier.push_back(y);
+        }
+    }
+    if (from[v] < 0) return {};
+    vector<int> path;
+    for (int y = v; y != u; y = from[y]) path.push_back(g.edgeId(viaArc[y]));
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+bool AllPairs::preferred(const CsrGraph &g, int sources) {
+    const double v = g.vertexCount();
+    if (v > kMaxVertices) return false;
+    const double floyd = (useAvx2() ? kFloydStepCostAvx2 : kFloydStepCostScalar) * v * v * v;
+    double searches = sources * (g.arcCount() + v) * log2(v + 1.0);
+    if (g.integerWeights()) searches *= kBucketSearchCost;
+    return floyd <= searches;
+}
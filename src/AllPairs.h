@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class CsrGraph;
+
+namespace AllPairs {
+
+// All-pairs shortest distances by cache-blocked Floyd-Warshall over a flat
+// row-major matrix padded to whole kBlock x kBlock tiles. Each round relaxes
+// the diagonal tile, then its row and column tiles, then every other tile
+// (in parallel on the shared pool); a tile update is a min-plus product whose
+// inner loop runs on AVX2 when the CPU has it (checked at run time, so the
+// default build uses it too), plain doubles otherwise.
+// O(V^3) time and V^2 doubles, so it is meant for small or dense graphs.
+class DistanceMatrix {
+public:
+    static constexpr int kBlock = 32;
+
+    explicit DistanceMatrix(const CsrGraph &g);
+
+    int size() const { return n; }
+    double at(int u, int v) const { return d[static_cast<std::size_t>(u) * stride + v]; }
+
+    // Edge ids of a shortest u -> v path, recovered from the matrix by following
+    // arcs whose weight plus remaining distance matches the distance left.
+    // Empty if v is unreachable or equal to u.
+    std::vector<int> pathEdges(const CsrGraph &g, int u, int v) const;
+
+private:
+    int n{0};
+    int stride{0};
+    std::vector<double> d;
+
+    void relaxTile(int ib, int jb, int kb);
+};
+
+// Whether the matrix beats per-source searches for `sources` sources on g:
+// when V^3 stays under the searches' rough sources * E * log V cost (cheaper
+// with integer weights, which get bucket queues) and the matrix fits the
+// memory cap.
+bool preferred(const CsrGraph &g, int sources);
+
+}
@@ -1,79 +1,85 @@
 ﻿#include "Algorithms.h"
+#include "AllPairs.h"
 #include "ChinesePostman.h"
-#include <queue>
+#include "ContractionHierarchy.h"
+#include "CsrGraph.h"
+#include "Matching.h"
+#include "ShortestPath.h"
+#include "ThreadPool.h"
 #include <limits>
 #include <algorithm>
-#include <map>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
 
 using namespace std;
 
-// Dijkstra trả về đường đi ngắn nhất từ s đến mọi đỉnh
-static vector<double> dijkstra(const Graph& g, int s, vector<int>& prev) {
-    const auto& verts = g.getVertices();
-    const auto& edges = g.getEdges();
-    vector<double> dist(verts.size(), numeric_limits<double>::infinity());
-    prev.assign(verts.size(), -1);
-    dist[s] = 0;
-    using P = pair<double, int>;
-    priority_queue<P, vector<P>, greater<P>> pq;
-    pq.emplace(0, s);
-    while (!pq.empty()) {
-        auto [d, u] = pq.top(); pq.pop();
-        if (d > dist[u]) continue;
-        for (int eid : g.adjacency().at(u)) {
-            const auto& e = edges[eid];
-            int v = (e.u == u) ? e.v : e.u;
-            double w = e.weight;
-            if (dist[v] > dist[u] + w) {
-                dist[v] = dist[u] + w;
-                prev[v] = u;
-                pq.emplace(dist[v], v);
-            }
+// Quy hoạch động bitmask O(2^k·k) cho tập đỉnh lẻ nhỏ: dp[mask] là chi phí nhỏ nhất
+// để ghép các đỉnh trong mask. Bảng dp và bảng lựa chọn là mảng phẳng theo mask,
+// kiểu Mask (số nguyên không dấu) quyết định số đỉnh tối đa.
+template <typename Mask>
+static bool bitmaskMatching(const vector<vector<double>>& cost, vector<pair<int,int>>& bestMatching, double& minCost) {
+    static_assert(is_unsigned<Mask>::value, "Mask must be an unsigned integer type");
+    const int n = static_cast<int>(cost.size());
+    if (n % 2 != 0 || n > numeric_limits<Mask>::digits || n > 256) return false;
+    const size_t states = size_t(1) << n;
+    const Mask full = static_cast<Mask>(states - 1);
+    const double inf = numeric_limits<double>::infinity();
+    vector<double> dp(states, inf);
+    vector<uint16_t> choice(states, 0); // (i << 8) | j của cặp cuối cùng được thêm
+    dp[0] = 0;
+    for (size_t m = 0; m < states - 1; ++m) {
+        const Mask mask = static_cast<Mask>(m);
+        const double d = dp[m];
+        if (d == inf) continue;
+        // luôn ghép đỉnh chưa dùng có chỉ số nhỏ nhất
+        int i = 0;
+        while (mask & (Mask(1) << i)) ++i;
+        const double* row = cost[i].data();
+        for (int j = i + 1; j < n; ++j) {
+            if (mask & (Mask(1) << j)) continue;
+            const Mask next = static_cast<Mask>(mask | (Mask(1) << i) | (Mask(1) << j));
+            const double nd = d + row[j];
+            if (nd < dp[next]) { dp[next] = nd; choice[next] = static_cast<uint16_t>((i << 8) | j); }
         }
     }
-    return dist;
+    if (dp[full] == inf) return false;
+    minCost = dp[full];
+    bestMatching.clear();
+    for (Mask mask = full; mask != 0; ) {
+        int i = choice[mask] >> 8, j = choice[mask] & 0xFF;
+        bestMatching.emplace_back(i, j);
+        mask = static_cast<Mask>(mask & ~((Mask(1) << i) | (Mask(1) << j)));
+    }
+    reverse(bestMatching.begin(), bestMatching.end());
+    return true;
 }
 
-// Sinh tất cả các matching giữa các đỉnh lẻ, trả về matching có tổng trọng số nhỏ nhất
+// DP tốn khoảng 2^k·k/2 phép thử, blossom khoảng k^3: hai chi phí ngang nhau quanh k = 10..12,
+// sau đó DP tăng gấp bốn mỗi khi k tăng 2 nên không đáng mở rộng Mask lên uint32_t
+static constexpr int kBitmaskMatchingMaxOdd = 12;
+static_assert(kBitmaskMatchingMaxOdd <= numeric_limits<uint16_t>::digits, "Mask uint16_t phải chứa đủ k bit");
+
+// Khi ít nhất 1/8 số đỉnh là đỉnh lẻ, quét theo nhóm nguồn nhanh hơn Dijkstra dừng sớm từng nguồn
+static constexpr int kBatchedMinOddShare = 8;
+// Mỗi luồng giữ một BatchWorkspace cỡ bytesPerVertex x V; quá ngưỡng này thì dùng Dijkstra từng nguồn
+static constexpr size_t kBatchedMaxScratchBytes = size_t(256) << 20;
+
+// Ghép cặp hoàn hảo trọng số nhỏ nhất giữa các đỉnh lẻ: DP bitmask khi k nhỏ, blossom O(k^3) khi k lớn
 static void minWeightMatching(const vector<vector<double>>& cost, vector<pair<int,int>>& bestMatching, double& minCost) {
-    int n = cost.size();
-    vector<int> idx(n);
-    for (int i = 0; i < n; ++i) idx[i] = i;
-    minCost = numeric_limits<double>::infinity();
-    vector<pair<int,int>> matching;
-    function<void(int, double)> dfs = [&](int i, double acc) {
-        if (i == n) {
-            if (acc < minCost) {
-                minCost = acc;
-                bestMatching = matching;
-            }
-            return;
-        }
-        if (idx[i] == -1) { dfs(i+1, acc); return; }
-        for (int j = i+1; j < n; ++j) {
-            if (idx[j] == -1) continue;
-            matching.emplace_back(idx[i], idx[j]);
-            int a = idx[i], b = idx[j];
-            int oldi = idx[i], oldj = idx[j];
-            idx[i] = idx[j] = -1;
-            dfs(i+1, acc + cost[a][b]);
-            idx[i] = oldi; idx[j] = oldj;
-            matching.pop_back();
+    if (cost.size() <= static_cast<size_t>(kBitmaskMatchingMaxOdd) &&
+        bitmaskMatching<uint16_t>(cost, bestMatching, minCost)) {
+        return;
+    }
+    vector<int> mate = Matching::minWeightPerfectMatching(cost);
+    bestMatching.clear();
+    minCost = 0;
+    for (int i = 0; i < (int)mate.size(); ++i) {
+        if (mate[i] > i) {
+            bestMatching.emplace_back(i, mate[i]);
+            minCost += cost[i][mate[i]];
         }
-    };
-    dfs(0, 0);
-}
-
-// Truy vết đường đi ngắn nhất từ prev
-static vector<int> reconstructPath(int from, int to, const vector<int>& prev) {
-    vector<int> path;
-    for (int v = to; v != from; v = prev[v]) {
-        if (v == -1) return {};
-        path.push_back(v);
     }
-    path.push_back(from);
-    reverse(path.begin(), path.end());
-    return path;
 }
 
 ChinesePostmanResult ChinesePostmanOptimal::solve(const Graph& g) {
@@ -81,10 +87,9 @@ ChinesePostmanResult ChinesePostmanOptimal::solve(const Graph& g) {
     const auto& verts = g.getVertices();
     const auto& edges = g.getEdges();
     // 1. Tìm các đỉnh bậc lẻ
-    vector<int> odd;
-    for (size_t i = 0; i < verts.size(); ++i) {
-        if (g.degree(static_cast<int>(i)) % 2 == 1) odd.push_back(static_cast<int>(i));
-    }
+    // Graph giữ sẵn tập đỉnh lẻ; sắp theo id để các nguồn gom lô liền nhau
+    vector<int> odd = g.oddVertices();
+    sort(odd.begin(), odd.end());
     if (odd.empty()) {
         // Đã Eulerian, chỉ cần tìm Euler circuit
         auto eulerRes = Algorithms::findEulerTourHierholzer(g);
@@ -97,15 +102,64 @@ ChinesePostmanResult ChinesePostmanOptimal::solve(const Graph& g) {
     // 2. Tìm đường đi ngắn nhất giữa các đỉnh lẻ
     int n = odd.size();
     vector<vector<double>> cost(n, vector<double>(n, 1e9));
-    vector<vector<vector<int>>> paths(n, vector<vector<int>>(n));
-    for (int i = 0; i < n; ++i) {
-        vector<int> prev;
-        auto dist = dijkstra(g, odd[i], prev);
-        for (int j = 0; j < n; ++j) {
-            if (i != j) {
-                cost[i][j] = dist[odd[j]];
-                paths[i][j] = reconstructPath(odd[i], odd[j], prev);
+    // Mỗi nguồn i chỉ giữ phần cây truy vết nằm trên đường tới các đỉnh lẻ j > i (dạng thưa,
+    // không phải mảng V phần tử); đường đi được dựng lại sau khi ghép cặp, chỉ cho k/2 cặp dùng đến
+    vector<ShortestPath::SparseTree> trees(n);
+    const ContractionHierarchy* ch = g.contractionHierarchy();
+    unique_ptr<AllPairs::DistanceMatrix> matrix;
+    if (ch) {
+        // Có sẵn chỉ mục CH: bảng khoảng cách k x k từ các tìm kiếm hướng lên, không cần Dijkstra
+        cost = ch->distanceTable(odd);
+    } else if (AllPairs::preferred(g.csr(), n)) {
+        // Đồ thị nhỏ hoặc dày: Floyd-Warshall theo khối trên ma trận phẳng rẻ hơn k lần Dijkstra
+        matrix = make_unique<AllPairs::DistanceMatrix>(g.csr());
+        for (int i = 0; i < n; ++i) {
+            for (int j = i + 1; j < n; ++j) {
+                cost[i][j] = cost[j][i] = matrix->at(odd[i], odd[j]);
+            }
+        }
+    } else {
+        const CsrGraph& csr = g.csr(); // dựng trước khi chia luồng
+        // Các lần Dijkstra độc lập nhau: chạy song song, mỗi luồng dùng workspace riêng
+        ThreadPool& pool = ThreadPool::shared();
+        vector<ShortestPath::Workspace> scratch(pool.workerCount());
+        vector<int> oddIndex(verts.size(), -1);
+        for (int i = 0; i < n; ++i) oddIndex[odd[i]] = i;
+        auto searchFrom = [&](int i, int worker) {
+            ShortestPath::Workspace& ws = scratch[worker];
+            // d(i,j) = d(j,i) nên nguồn i chỉ chờ các đỉnh lẻ j > i, dừng ngay khi chúng đã chốt
+            ShortestPath::dijkstraToTargets(csr, odd[i], ws, [&](int v) { return oddIndex[v] > i; }, n - 1 - i);
+            for (int j = i + 1; j < n; ++j) {
+                cost[i][j] = cost[j][i] = ws.dist[odd[j]];
             }
+            ShortestPath::keepPaths(ws, edges, odd[i], odd.data() + i + 1, n - 1 - i, trees[i]);
+        };
+        const size_t batchScratchBytes = pool.workerCount() * verts.size() * ShortestPath::BatchWorkspace::bytesPerVertex;
+        if (n >= 2 * ShortestPath::kBatchLanes && n * kBatchedMinOddShare >= static_cast<int>(verts.size()) &&
+            batchScratchBytes <= kBatchedMaxScratchBytes) {
+            // Đỉnh lẻ dày đặc: gom kBatchLanes nguồn liền nhau (nên gần nhau) vào một lượt quét,
+            // mỗi cung chỉ đọc một lần cho cả nhóm
+            vector<ShortestPath::BatchWorkspace> batchScratch(pool.workerCount());
+            const int batches = (n + ShortestPath::kBatchLanes - 1) / ShortestPath::kBatchLanes;
+            pool.parallelFor(batches, [&](int b, int worker) {
+                ShortestPath::BatchWorkspace& bw = batchScratch[worker];
+                const int first = b * ShortestPath::kBatchLanes;
+                const int count = min(ShortestPath::kBatchLanes, n - first);
+                if (!ShortestPath::batchedSearch(csr, &odd[first], count, bw)) {
+                    // Nguồn của nhóm ở xa nhau, quét lặp quá nhiều: làm lại bằng Dijkstra từng nguồn
+                    for (int i = first; i < first + count; ++i) searchFrom(i, worker);
+                    return;
+                }
+                for (int lane = 0; lane < count; ++lane) {
+                    const int i = first + lane;
+                    for (int j = i + 1; j < n; ++j) {
+                        cost[i][j] = cost[j][i] = bw.distance(lane, odd[j]);
+                    }
+                    bw.keepPaths(lane, edges, odd[i], odd.data() + i + 1, n - 1 - i, trees[i]);
+                }
+            });
+        } else {
+            pool.parallelFor(n, searchFrom);
         }
     }
     // 3. Ghép cặp tối ưu
@@ -113,55 +167,25 @@ ChinesePostmanResult ChinesePostmanOptimal::solve(const Graph& g) {
     double minCost = 0;
     minWeightMatching(cost, matching, minCost);
     // 4. Tạo multigraph mới: thêm các đường đi duplicate
-    struct MultiEdge { int u, v, id; double weight; };
-    vector<MultiEdge> multiEdges;
-    for (const auto& e : edges) {
-        multiEdges.push_back({e.u, e.v, e.id, e.weight});
-    }
-    map<pair<int,int>, int> edgeDup;
-    map<int, vector<int>> dupPath; // lưu mapping duplicate edge -> path gốc
-    int nextId = static_cast<int>(edges.size());
+    vector<Edge> multiEdges = edges;
     for (auto& p : matching) {
-        const auto& path = paths[p.first][p.second];
-        for (size_t i = 1; i < path.size(); ++i) {
-            int u = path[i-1], v = path[i];
-            if (u > v) std::swap(u, v);
-            // thêm 1 cạnh duplicate với id mới
-            int dupId = nextId++;
-            multiEdges.push_back({u, v, dupId, 1.0});
-            // lưu đường đi thật (danh sách id cạnh gốc) vào dupPath
-            vector<int> realEdges;
-            for (const auto& e : edges) {
-                if ((e.u == path[i-1] && e.v == path[i]) ||
-                    (e.v == path[i-1] && e.u == path[i])) {
-                    realEdges.push_back(e.id);
-                    break;
-                }
-            }
-            dupPath[dupId] = realEdges;
+        // đường đi của cặp (i, j) nằm trong cây của nguồn có chỉ số nhỏ hơn
+        int i = min(p.first, p.second), j = max(p.first, p.second);
+        // đi ngược cây cạnh truy vết (hoặc bung shortcut của CH, hoặc lần theo ma trận khoảng cách), giữ nguyên trọng số thật
+        vector<int> path = ch ? ch->route(odd[i], odd[j]).edges
+                         : matrix ? matrix->pathEdges(g.csr(), odd[i], odd[j])
+                                  : ShortestPath::pathEdges(trees[i], edges, odd[i], odd[j]);
+        for (int eid : path) {
+            const Edge& e = edges[eid];
+            // thêm 1 cạnh duplicate (id mới là vị trí của nó), ghi lại cạnh gốc tương ứng
+            multiEdges.push_back(Edge{e.u, e.v, e.weight});
+            result.duplicateOf.push_back(eid);
         }
     }
     // 5. Tìm Euler circuit trên multigraph
-    map<int, vector<pair<int,int>>> adj; // u -> list of (v, edgeIdx)
-    for (size_t i = 0; i < multiEdges.size(); ++i) {
-        const auto& e = multiEdges[i];
-        adj[e.u].emplace_back(e.v, static_cast<int>(i));
-        adj[e.v].emplace_back(e.u, static_cast<int>(i));
-    }
-    vector<bool> used(multiEdges.size(), false);
-    vector<int> circuit;
+    CsrGraph multi(static_cast<int>(verts.size()), multiEdges);
     int startVertex = odd.empty() ? 0 : odd[0];
-    function<void(int)> dfs = [&](int u) {
-        while (!adj[u].empty()) {
-            auto [v, eid] = adj[u].back(); adj[u].pop_back();
-            if (used[eid]) continue;
-            used[eid] = true;
-            dfs(v);
-            circuit.push_back(multiEdges[eid].id);
-        }
-    };
-    dfs(startVertex);
-    reverse(circuit.begin(), circuit.end());
+    vector<int> circuit = Algorithms::eulerEdgeOrder(multi, static_cast<int>(multiEdges.size()), startVertex);
     // 6. Lưu lại thứ tự id cạnh (bao gồm cả cạnh duplicate)
     for (int eid : circuit) {
         result.edgeOrder.push_back(eid);
@@ -6,6 +6,7 @@
 struct ChinesePostmanResult {
     std::vector<int> edgeOrder; // Euler circuit edge ids (c th? c duplicate)
     bool isCycle = true;
+    std::vector<int> duplicateOf; // duplicateOf[id - edge count] = original edge id of a duplicate
 };
 
 namespace ChinesePostmanOptimal {
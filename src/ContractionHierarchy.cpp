@@ -0,0 +1,474 @@
+#include "ContractionHierarchy.h"
+#include "Graph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <queue>
+
+using namespace std;
+
+namespace {
+
+const double kInf = numeric_limits<double>::infinity();
+// Witness searches give up after this many settled vertices; a missed witness
+// only costs a redundant shortcut, never a wrong distance.
+constexpr int kWitnessSettleLimit = 500;
+// Contracted vertices between two progress reports.
+constexpr size_t kProgressInterval = 256;
+
+using QN = pair<double, int>;
+
+struct Arc {
+    int to;
+    double weight;
+    int via; // original edge id, or ~shortcut index
+};
+
+// Overlay graph of the vertices not contracted yet, kept symmetric. Parallel
+// edges collapse to the lightest one and self-loops are dropped.
+class Contractor {
+public:
+    explicit Contractor(const Graph &graph)
+        : n(static_cast<int>(graph.getVertices().size())), adj(n), deletedNeighbors(n, 0), witnessDist(n, kInf), isTarget(n, 0) {
+        for (const auto &e : graph.liveEdges()) {
+            if (e.u < 0 || e.v < 0 || e.u >= n || e.v >= n || e.u == e.v) continue;
+            link(e.u, e.v, e.weight, graph.idOf(e));
+            link(e.v, e.u, e.weight, graph.idOf(e));
+        }
+    }
+
+    // Contracts every vertex; up[v] receives v's arcs to higher-ranked vertices
+    // and order the vertices from lowest to highest rank. False if progress
+    // asked to stop.
+    bool run(vector<vector<Arc>> &up, vector<int> &order, vector<ContractionHierarchy::Shortcut> &shortcuts,
+             const ContractionHierarchy::Progress &progress) {
+        up.assign(n, {});
+        order.clear();
+        order.reserve(n);
+        vector<char> contracted(n, 0);
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> queue;
+        for (int v = 0; v < n; ++v) queue.emplace(priority(v), v);
+        while (!queue.empty()) {
+            int v = queue.top().second;
+            queue.pop();
+            if (contracted[v]) continue;
+            // lazy update: re-queue v if its priority went stale and is now worse than the next
+            int now = priority(v); // also leaves v's shortcuts in pending
+            if (!queue.empty() && now > queue.top().first) {
+                queue.emplace(now, v);
+                continue;
+            }
+            up[v] = adj[v];
+            order.push_back(v);
+            for (const auto &p : pending) {
+                const Arc *existing = find(p.u, p.w);
+                if (existing && existing->weight <= p.weight) continue;
+                int s = static_cast<int>(shortcuts.size());
+                shortcuts.push_back({p.u, p.w, v, p.viaU, p.viaW});
+                link(p.u, p.w, p.weight, ~s);
+                link(p.w, p.u, p.weight, ~s);
+            }
+            for (const Arc &a : adj[v]) {
+                auto &list = adj[a.to];
+                list.erase(remove_if(list.begin(), list.end(), [v](const Arc &x) { return x.to == v; }), list.end());
+                ++deletedNeighbors[a.to];
+            }
+            adj[v].clear();
+            contracted[v] = 1;
+            if (progress && order.size() % kProgressInterval == 0 && !progress(static_cast<int>(order.size()), n)) return false;
+        }
+        return true;
+    }
+
+private:
+    struct Pending {
+        int u, w;
+        double weight;
+        int viaU, viaW;
+    };
+
+    int n;
+    vector<vector<Arc>> adj;
+    vector<int> deletedNeighbors;
+    vector<Pending> pending;
+    vector<double> witnessDist;
+    vector<char> isTarget;
+    vector<int> witnessTouched;
+    vector<QN> heap;
+
+    const Arc *find(int a, int b) const {
+        for (const Arc &x : adj[a])
+            if (x.to == b) return &x;
+        return nullptr;
+    }
+
+    void link(int a, int b, double weight, int via) {
+        for (Arc &x : adj[a]) {
+            if (x.to != b) continue;
+            if (weight < x.weight) { x.weight = weight; x.via = via; }
+            return;
+        }
+        adj[a].push_back({b, weight, via});
+    }
+
+    // Edge difference plus contracted neighbours, which spreads contraction evenly
+    int priority(int v) {
+        findShortcuts(v);
+        return static_cast<int>(pending.size()) - static_cast<int>(adj[v].size()) + deletedNeighbors[v];
+    }
+
+    // Fills pending with the shortcuts that contracting v requires
+    void findShortcuts(int v) {
+        pending.clear();
+        const auto &nb = adj[v];
+        for (size_t i = 0; i + 1 < nb.size(); ++i) {
+            // only pairs (i, j > i): the graph is undirected
+            double maxWeight = 0.0;
+            for (size_t j = i + 1; j < nb.size(); ++j) {
+                maxWeight = max(maxWeight, nb[j].weight);
+                isTarget[nb[j].to] = 1;
+            }
+            witnessSearch(nb[i].to, v, nb[i].weight + maxWeight, static_cast<int>(nb.size() - i - 1));
+            for (size_t j = i + 1; j < nb.size(); ++j) {
+                isTarget[nb[j].to] = 0;
+                double viaV = nb[i].weight + nb[j].weight;
+                if (witnessDist[nb[j].to] > viaV) pending.push_back({nb[i].to, nb[j].to, viaV, nb[i].via, nb[j].via});
+            }
+            for (int x : witnessTouched) witnessDist[x] = kInf;
+            witnessTouched.clear();
+        }
+    }
+
+    // Bounded Dijkstra from source that never enters avoid, stopping once the
+    // marked targets are settled. witnessDist holds lengths of real paths, so
+    // any value <= the path through avoid is a witness.
+    void witnessSearch(int source, int avoid, double limit, int targets) {
+        heap.clear();
+        witnessDist[source] = 0.0;
+        witnessTouched.push_back(source);
+        heap.emplace_back(0.0, source);
+        int settled = 0;
+        while (!heap.empty() && settled < kWitnessSettleLimit) {
+            pop_heap(heap.begin(), heap.end(), greater<QN>());
+            auto [d, u] = heap.back();
+            heap.pop_back();
+            if (d > witnessDist[u]) continue;
+            if (d > limit) break;
+            if (isTarget[u] && --targets == 0) break;
+            ++settled;
+            for (const Arc &a : adj[u]) {
+                if (a.to == avoid) continue;
+                double nd = d + a.weight;
+                if (nd < witnessDist[a.to]) {
+                    if (witnessDist[a.to] == kInf) witnessTouched.push_back(a.to);
+                    witnessDist[a.to] = nd;
+                    heap.emplace_back(nd, a.to);
+                    push_heap(heap.begin(), heap.end(), greater<QN>());
+                }
+            }
+        }
+    }
+};
+
+// Query scratch, one per thread, grown to the largest index queried and
+// reset only at the vertices a search touched.
+struct Scratch {
+    vector<double> dist[2];
+    vector<int> fromVertex[2];
+    vector<int> fromArc[2];
+    vector<QN> heap[2];
+    vector<int> touched;
+    vector<pair<int, int>> stack; // shortcut unpacking
+
+    void ensure(int n) {
+        for (int side = 0; side < 2; ++side) {
+            if (static_cast<int>(dist[side].size()) >= n) continue;
+            dist[side].resize(n, kInf);
+            fromVertex[side].resize(n, -1);
+            fromArc[side].resize(n, -1);
+        }
+    }
+
+    void reach(int side, int v, double d, int from, int arc) {
+        if (dist[0][v] == kInf && dist[1][v] == kInf) touched.push_back(v);
+        dist[side][v] = d;
+        fromVertex[side][v] = from;
+        fromArc[side][v] = arc;
+        heap[side].emplace_back(d, v);
+        push_heap(heap[side].begin(), heap[side].end(), greater<QN>());
+    }
+
+    void reset() {
+        for (int v : touched) dist[0][v] = dist[1][v] = kInf;
+        touched.clear();
+        heap[0].clear();
+        heap[1].clear();
+    }
+};
+
+Scratch &scratch(int n) {
+    thread_local Scratch s;
+    s.ensure(n);
+    return s;
+}
+
+template <typename T>
+void writeVector(ofstream &out, const vector<T> &v) {
+    uint64_t size = v.size();
+    out.write(reinterpret_cast<const char *>(&size), sizeof size);
+    out.write(reinterpret_cast<const char *>(v.data()), static_cast<streamsize>(v.size() * sizeof(T)));
+}
+
+template <typename T>
+bool readVector(ifstream &in, vector<T> &v) {
+    uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char *>(&size), sizeof size)) return false;
+    if (size > (uint64_t(1) << 32)) return false;
+    v.resize(static_cast<size_t>(size));
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(v.data()), static_cast<streamsize>(v.size() * sizeof(T))));
+}
+
+const char kMagic[8] = {'C', 'H', 'I', 'N', 'D', 'E', 'X', '1'};
+
+} // namespace
+
+ContractionHierarchy::ContractionHierarchy(const Graph &graph) { construct(graph, {}); }
+
+shared_ptr<const ContractionHierarchy> ContractionHierarchy::build(const Graph &graph, const Progress &progress) {
+    auto index = make_shared<ContractionHierarchy>();
+    if (!index->construct(graph, progress)) return nullptr;
+    return index;
+}
+
+bool ContractionHierarchy::construct(const Graph &graph, const Progress &progress) {
+    fingerprint = fingerprintOf(graph);
+    vector<vector<Arc>> up;
+    if (!Contractor(graph).run(up, vertexAt, shortcuts, progress)) return false;
+    const int n = static_cast<int>(up.size());
+    rankOf.assign(n, 0);
+    for (int r = 0; r < n; ++r) rankOf[vertexAt[r]] = r;
+    // number the search graph by rank: upward searches then walk towards the
+    // end of the arrays, where the few high-ranked vertices share cache lines
+    upOffsets.assign(static_cast<size_t>(n) + 1, 0);
+    for (int r = 0; r < n; ++r) upOffsets[r + 1] = upOffsets[r] + static_cast<int>(up[vertexAt[r]].size());
+    upTargets.reserve(upOffsets[n]);
+    upWeights.reserve(upOffsets[n]);
+    upVia.reserve(upOffsets[n]);
+    for (int r = 0; r < n; ++r) {
+        for (const Arc &a : up[vertexAt[r]]) {
+            upTargets.push_back(rankOf[a.to]);
+            upWeights.push_back(a.weight);
+            upVia.push_back(a.via);
+        }
+    }
+    return true;
+}
+
+uint64_t ContractionHierarchy::fingerprintOf(const Graph &graph) {
+    // FNV-1a over the fields that determine shortest paths
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void *data, size_t size) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+    };
+    uint64_t n = graph.getVertices().size();
+    mix(&n, sizeof n);
+    for (const auto &e : graph.getEdges()) {
+        // tombstones still occupy an id, so they count as an empty slot
+        int32_t ends[2] = {e.removed ? -1 : e.u, e.removed ? -1 : e.v};
+        mix(ends, sizeof ends);
+        // the index itself ignores direction, but a graph that differs only in
+        // it must not pick up an index saved for the other one
+        uint8_t directed = !e.removed && e.directed;
+        mix(&directed, sizeof directed);
+        mix(&e.weight, sizeof e.weight);
+    }
+    return h;
+}
+
+double ContractionHierarchy::query(int source, int target, vector<int> *edges, int *settled) const {
+    const int n = vertexCount();
+    if (settled) *settled = 0;
+    if (source < 0 || target < 0 || source >= n || target >= n) return kInf;
+    Scratch &sc = scratch(n);
+    const int s = rankOf[source], t = rankOf[target];
+    sc.reach(0, s, 0.0, -1, -1);
+    sc.reach(1, t, 0.0, -1, -1);
+
+    // Both searches only climb to higher ranks; the shortest path peaks at the
+    // vertex where their settled distances sum to the minimum.
+    double best = kInf;
+    int top = -1;
+    while (!sc.heap[0].empty() || !sc.heap[1].empty()) {
+        int side = (sc.heap[1].empty() ||
+                    (!sc.heap[0].empty() && sc.heap[0].front().first <= sc.heap[1].front().first)) ? 0 : 1;
+        auto &heap = sc.heap[side];
+        pop_heap(heap.begin(), heap.end(), greater<QN>());
+        auto [d, u] = heap.back();
+        heap.pop_back();
+        if (d > sc.dist[side][u]) continue;
+        if (d >= best) { heap.clear(); continue; } // this side can no longer improve
+        if (settled) ++*settled;
+        double other = sc.dist[1 - side][u];
+        if (d + other < best) { best = d + other; top = u; }
+        if (stalled(u, d, sc.dist[side])) continue;
+        for (int a = upOffsets[u]; a < upOffsets[u + 1]; ++a) {
+            double nd = d + upWeights[a];
+            if (nd < sc.dist[side][upTargets[a]]) sc.reach(side, upTargets[a], nd, u, a);
+        }
+    }
+
+    if (edges && top >= 0) {
+        edges->clear();
+        // source side: collect the upward hops top -> source, then unpack them in travel order
+        vector<pair<int, int>> climb; // (arc, tail)
+        for (int v = top; v != s; v = sc.fromVertex[0][v]) climb.emplace_back(sc.fromArc[0][v], sc.fromVertex[0][v]);
+        for (auto it = climb.rbegin(); it != climb.rend(); ++it) unpack(upVia[it->first], vertexAt[it->second], *edges);
+        // target side: descend top -> target along the backward search tree
+        for (int v = top; v != t; v = sc.fromVertex[1][v]) unpack(upVia[sc.fromArc[1][v]], vertexAt[v], *edges);
+    }
+    sc.reset();
+    return best;
+}
+
+bool ContractionHierarchy::stalled(int u, double d, const vector<double> &dist) const {
+    // Stall-on-demand: the graph is undirected, so u's upward arcs double as the
+    // downward arcs into u. If a higher vertex already reached offers a shorter
+    // way down, d is not a shortest distance and nothing found from u can be.
+    for (int a = upOffsets[u]; a < upOffsets[u + 1]; ++a)
+        if (dist[upTargets[a]] + upWeights[a] < d) return true;
+    return false;
+}
+
+void ContractionHierarchy::unpack(int via, int from, vector<int> &out) const {
+    auto &stack = scratch(vertexCount()).stack;
+    stack.clear();
+    stack.emplace_back(via, from);
+    while (!stack.empty()) {
+        auto [v, x] = stack.back();
+        stack.pop_back();
+        if (v >= 0) { out.push_back(v); continue; }
+        const Shortcut &s = shortcuts[~v];
+        // push the half leaving x last so it is expanded first
+        if (x == s.from) {
+            stack.emplace_back(s.second, s.middle);
+            stack.emplace_back(s.first, s.from);
+        } else {
+            stack.emplace_back(s.first, s.middle);
+            stack.emplace_back(s.second, s.to);
+        }
+    }
+}
+
+double ContractionHierarchy::distance(int source, int target, int *settled) const {
+    return query(source, target, nullptr, settled);
+}
+
+ShortestPath::Route ContractionHierarchy::route(int source, int target, int *settled) const {
+    ShortestPath::Route r;
+    r.length = query(source, target, &r.edges, settled);
+    if (r.length == kInf) r.edges.clear();
+    return r;
+}
+
+vector<vector<double>> ContractionHierarchy::distanceTable(const vector<int> &vertices) const {
+    const int k = static_cast<int>(vertices.size());
+    const int n = vertexCount();
+    vector<vector<double>> table(k, vector<double>(k, kInf));
+    // upward search space of every vertex: (vertex, distance) pairs
+    vector<vector<pair<int, double>>> space(k);
+    ThreadPool::shared().parallelFor(k, [&](int i, int) {
+        if (vertices[i] < 0 || vertices[i] >= n) return;
+        const int s = rankOf[vertices[i]];
+        Scratch &sc = scratch(n);
+        sc.reach(0, s, 0.0, -1, -1);
+        auto &heap = sc.heap[0];
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), greater<QN>());
+            auto [d, u] = heap.back();
+            heap.pop_back();
+            if (d > sc.dist[0][u] || stalled(u, d, sc.dist[0])) continue;
+            space[i].emplace_back(u, d);
+            for (int a = upOffsets[u]; a < upOffsets[u + 1]; ++a) {
+                double nd = d + upWeights[a];
+                if (nd < sc.dist[0][upTargets[a]]) sc.reach(0, upTargets[a], nd, u, a);
+            }
+        }
+        sc.reset();
+    });
+
+    // buckets: for every vertex, which search spaces contain it and at what distance
+    vector<int> bucketBegin(static_cast<size_t>(n) + 1, 0);
+    for (const auto &sp : space)
+        for (const auto &entry : sp) ++bucketBegin[entry.first + 1];
+    for (int v = 0; v < n; ++v) bucketBegin[v + 1] += bucketBegin[v];
+    vector<pair<int, double>> buckets(bucketBegin[n]);
+    vector<int> cursor(bucketBegin.begin(), bucketBegin.end() - 1);
+    for (int i = 0; i < k; ++i)
+        for (const auto &entry : space[i]) buckets[cursor[entry.first]++] = {i, entry.second};
+
+    ThreadPool::shared().parallelFor(k, [&](int i, int) {
+        vector<double> &row = table[i];
+        for (const auto &entry : space[i]) {
+            for (int b = bucketBegin[entry.first]; b < bucketBegin[entry.first + 1]; ++b) {
+                double d = entry.second + buckets[b].second;
+                if (d < row[buckets[b].first]) row[buckets[b].first] = d;
+            }
+        }
+    });
+    return table;
+}
+
+bool ContractionHierarchy::save(const string &path) const {
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) return false;
+    out.write(kMagic, sizeof kMagic);
+    out.write(reinterpret_cast<const char *>(&fingerprint), sizeof fingerprint);
+    writeVector(out, vertexAt);
+    writeVector(out, upOffsets);
+    writeVector(out, upTargets);
+    writeVector(out, upWeights);
+    writeVector(out, upVia);
+    writeVector(out, shortcuts);
+    return static_cast<bool>(out);
+}
+
+bool ContractionHierarchy::load(const string &path, const Graph &graph) {
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    char magic[sizeof kMagic];
+    ContractionHierarchy loaded;
+    if (!in.read(magic, sizeof magic) || memcmp(magic, kMagic, sizeof kMagic) != 0) return false;
+    if (!in.read(reinterpret_cast<char *>(&loaded.fingerprint), sizeof loaded.fingerprint)) return false;
+    if (loaded.fingerprint != fingerprintOf(graph)) return false;
+    if (!readVector(in, loaded.vertexAt) || !readVector(in, loaded.upOffsets) || !readVector(in, loaded.upTargets) || !readVector(in, loaded.upWeights) ||
+        !readVector(in, loaded.upVia) || !readVector(in, loaded.shortcuts))
+        return false;
+
+    // reject truncated or inconsistent files rather than index out of bounds later
+    const int n = loaded.vertexCount();
+    const int arcs = static_cast<int>(loaded.upTargets.size());
+    const int edgeCount = static_cast<int>(graph.getEdges().size());
+    const int shortcutCount = loaded.shortcutCount();
+    auto validVia = [&](int via) { return via >= 0 ? via < edgeCount : ~via < shortcutCount; };
+    if (n != static_cast<int>(graph.getVertices().size()) || loaded.upOffsets.front() != 0 || loaded.upOffsets.back() != arcs ||
+        static_cast<int>(loaded.upWeights.size()) != arcs || static_cast<int>(loaded.upVia.size()) != arcs)
+        return false;
+    for (int v = 0; v < n; ++v)
+        if (loaded.upOffsets[v] > loaded.upOffsets[v + 1]) return false;
+    if (static_cast<int>(loaded.vertexAt.size()) != n) return false;
+    loaded.rankOf.assign(n, -1);
+    for (int r = 0; r < n; ++r) {
+        int v = loaded.vertexAt[r];
+        if (v < 0 || v >= n || loaded.rankOf[v] != -1) return false; // not a permutation
+        loaded.rankOf[v] = r;
+    }
+    for (int a = 0; a < arcs; ++a)
+        if (loaded.upTargets[a] < 0 || loaded.upTargets[a] >= n || !validVia(loaded.upVia[a])) return false;
+    for (const Shortcut &s : loaded.shortcuts)
+        if (s.middle < 0 || s.middle >= n || !validVia(s.first) || !validVia(s.second)) return false;
+
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ShortestPath.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Graph;
+
+// Contraction-hierarchy index for repeated shortest-path queries on a graph
+// whose edges rarely change. Preprocessing contracts the vertices one by one
+// in edge-difference order and inserts a shortcut wherever a local witness
+// search finds no path avoiding the contracted vertex. A query then runs two
+// small upward searches that meet at the highest-ranked vertex of the path,
+// and shortcuts are unpacked back into original edge ids.
+// Edges are treated as undirected, like the rest of the solvers.
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() = default;
+    explicit ContractionHierarchy(const Graph &graph);
+
+    // Called with (contracted, total) every few hundred contracted vertices;
+    // returning false abandons the build.
+    using Progress = std::function<bool(int done, int total)>;
+    // Same as the constructor, but reports progress and can be cancelled, in
+    // which case it returns null. Meant for a worker thread with a graph copy.
+    static std::shared_ptr<const ContractionHierarchy> build(const Graph &graph, const Progress &progress);
+
+    int vertexCount() const { return static_cast<int>(upOffsets.size()) - 1; }
+    int shortcutCount() const { return static_cast<int>(shortcuts.size()); }
+
+    // Hash of the vertex count and every edge's endpoints, direction flag and
+    // weight. An index answers queries for exactly the graphs that share its fingerprint.
+    static std::uint64_t fingerprintOf(const Graph &graph);
+    bool matches(const Graph &graph) const { return fingerprintOf(graph) == fingerprint; }
+
+    // Point-to-point queries; thread-safe, with per-thread scratch that is
+    // reset only where a search touched it. settled (optional) receives the
+    // number of vertices settled by both searches.
+    double distance(int source, int target, int *settled = nullptr) const;
+    ShortestPath::Route route(int source, int target, int *settled = nullptr) const;
+
+    // Symmetric |vertices| x |vertices| distance table (infinity when
+    // unreachable) from one upward search per vertex and bucket joins.
+    std::vector<std::vector<double>> distanceTable(const std::vector<int> &vertices) const;
+
+    // Binary image of the index, tagged with the graph fingerprint.
+    bool save(const std::string &path) const;
+    // Fails if the file is unreadable or was built for a different graph.
+    bool load(const std::string &path, const Graph &graph);
+
+    // A shortcut replaces the two-arc path from - middle - to; first and second
+    // are the arcs it stands for (original edge id, or ~shortcut index).
+    struct Shortcut {
+        int from, to, middle;
+        int first;  // covers from - middle
+        int second; // covers middle - to
+    };
+
+private:
+    std::uint64_t fingerprint{0};
+    std::vector<int> rankOf;   // vertex id -> rank (the search graph's numbering)
+    std::vector<int> vertexAt; // rank -> vertex id
+    // upward arcs (towards higher rank) of each rank, CSR layout
+    std::vector<int> upOffsets{0};
+    std::vector<int> upTargets; // ranks
+    std::vector<double> upWeights;
+    std::vector<int> upVia; // >= 0: original edge id, < 0: ~shortcut index
+    std::vector<Shortcut> shortcuts;
+
+    bool construct(const Graph &graph, const Progress &progress);
+    double query(int source, int target, std::vector<int> *edges, int *settled) const;
+    bool stalled(int u, double d, const std::vector<double> &dist) const;
+    void unpack(int via, int from, std::vector<int> &out) const;
+};
@@ -0,0 +1,37 @@
+#include "CsrGraph.h"
+#include "Graph.h"
+#include <algorithm>
+#include <cmath>
+
+CsrGraph::CsrGraph(int vertexCount, const std::vector<Edge>& edges) {
+    offsets.assign(static_cast<size_t>(vertexCount) + 1, 0);
+    auto valid = [vertexCount](const Edge &e) {
+        return !e.removed && e.u >= 0 && e.v >= 0 && e.u < vertexCount && e.v < vertexCount;
+    };
+
+    // count arcs per vertex (a self-loop contributes two arcs, like adjacency())
+    for (const auto &e : edges) {
+        if (!valid(e)) continue;
+        ++offsets[e.u + 1];
+        ++offsets[e.v + 1];
+    }
+    for (int u = 0; u < vertexCount; ++u) offsets[u + 1] += offsets[u];
+
+    const int arcs = offsets[vertexCount];
+    targets.resize(arcs);
+    edgeIds.resize(arcs);
+    weights.resize(arcs);
+
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (int id = 0; id < static_cast<int>(edges.size()); ++id) {
+        const Edge &e = edges[id];
+        if (!valid(e)) continue;
+        const double w = e.weight;
+        int a = cursor[e.u]++;
+        targets[a] = e.v; edgeIds[a] = id; weights[a] = w;
+        int b = cursor[e.v]++;
+        targets[b] = e.u; edgeIds[b] = id; weights[b] = w;
+        heaviest = std::max(heaviest, w);
+        if (!(w >= 0.0 && w < 4294967296.0 && std::floor(w) == w)) allIntegral = false;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+struct Edge;
+
+// Immutable compressed-sparse-row snapshot of a Graph's incidence lists.
+// The arcs of vertex u occupy [arcBegin(u), arcEnd(u)); every arc stores the
+// opposite endpoint, the originating edge id and the edge weight in parallel
+// packed arrays, so a neighbor scan walks contiguous memory only.
+class CsrGraph {
+public:
+    CsrGraph() = default;
+    // Builds the snapshot in O(V+E) with a counting pass over the edges;
+    // tombstoned edges are left out and removed vertices simply get no arcs.
+    // Arcs keep the edge insertion order, matching Graph::adjacency().
+    CsrGraph(int vertexCount, const std::vector<Edge>& edges);
+
+    int vertexCount() const { return static_cast<int>(offsets.size()) - 1; }
+    int arcCount() const { return static_cast<int>(targets.size()); }
+
+    int arcBegin(int u) const { return offsets[u]; }
+    int arcEnd(int u) const { return offsets[u + 1]; }
+    int degree(int u) const { return offsets[u + 1] - offsets[u]; }
+
+    int target(int arc) const { return targets[arc]; }
+    int edgeId(int arc) const { return edgeIds[arc]; }
+    double weight(int arc) const { return weights[arc]; }
+
+    // Weight profile, gathered while building: true when every weight is a
+    // non-negative integer below 2^32, so distances are exact integers and the
+    // searches may use an integer bucket queue instead of a binary heap.
+    bool integerWeights() const { return allIntegral; }
+    double maxWeight() const { return heaviest; }
+
+private:
+    std::vector<int> offsets{0}; // size V+1
+    std::vector<int> targets;    // opposite endpoint per arc
+    std::vector<int> edgeIds;    // edge id per arc
+    std::vector<double> weights; // edge weight per arc
+    bool allIntegral{true};
+    double heaviest{0.0};
+};
@@ -1,5 +1,8 @@
 #include "Graph.h"
-#include <queue>
+#include "CsrGraph.h"
+#include "ContractionHierarchy.h"
+#include "StrongComponents.h"
+#include <algorithm>
 
 static QString indexToLetters(int index) {
     QString s;
@@ -14,149 +17,370 @@ static QString indexToLetters(int index) {
 
 int Graph::addVertex(const QPointF &pos, const QString &name) {
     int id = static_cast<int>(vertices.size());
-    QString label = name.isEmpty() ? indexToLetters(id) : name;
-    vertices.push_back(Vertex{ id, label, pos });
+    int label = ~id; // generated from the creation index, so compaction keeps it
+    if (!name.isEmpty()) {
+        auto it = nameIndex.find(name);
+        if (it == nameIndex.end()) {
+            it = nameIndex.insert(name, static_cast<int>(namePool.size()));
+            namePool.push_back(name);
+        }
+        label = it.value();
+    }
+    vertices.push_back(Vertex{ label, pos });
+    degrees.push_back(0);
+    oddSlot.push_back(-1);
+    if (!componentsStale) {
+        components.add();
+        edgeful.push_back(0);
+        ++componentTotal;
+    }
+    csrCache.reset();
+    hierarchy.reset();
     return id;
 }
 
-int Graph::addEdge(int u, int v, double weight, bool directed) {
+int Graph::addEdge(int u, int v, double weight, bool directed, DuplicateEdgePolicy policy) {
+    if (policy != DuplicateEdgePolicy::AllowMulti) {
+        int existing = findParallel(u, v, directed);
+        if (existing >= 0) {
+            if (policy == DuplicateEdgePolicy::Reject) return -1;
+            if (weight < edges[existing].weight) {
+                edges[existing].weight = static_cast<EdgeWeight>(weight);
+                csrCache.reset();
+                hierarchy.reset();
+            }
+            return existing;
+        }
+    }
     int id = static_cast<int>(edges.size());
-    edges.push_back(Edge{ id, u, v, weight, directed });
+    edges.push_back(Edge{ u, v, static_cast<EdgeWeight>(weight), directed });
     vertexToEdgeIds[u].push_back(id);
     vertexToEdgeIds[v].push_back(id);
+    indexEdge(id);
+    addDegree(u, 1);
+    addDegree(v, 1);
+    if (!componentsStale) linkComponents(u, v);
+    csrCache.reset();
+    hierarchy.reset();
     return id;
 }
 
 void Graph::clear() {
     vertices.clear();
     edges.clear();
+    namePool.clear();
+    nameIndex.clear();
     vertexToEdgeIds.clear();
+    pairToEdge.clear();
+    nextParallel.clear();
+    removedVertices = 0;
+    removedEdges = 0;
+    degrees.clear();
+    odd.clear();
+    oddSlot.clear();
+    components.reset(0);
+    edgeful.clear();
+    componentTotal = 0;
+    edgefulComponents = 0;
+    componentsStale = false;
+    csrCache.reset();
+    hierarchy.reset();
 }
 
-void Graph::removeEdge(int edgeId) {
-    if (edgeId < 0 || static_cast<size_t>(edgeId) >= edges.size()) return;
-    Edge e = edges[edgeId];
-    // mark removal by swapping with last and popping to keep ids contiguous? we keep ids stable; rebuild structures instead
-    std::vector<Edge> newEdges;
-    newEdges.reserve(edges.size());
+void Graph::reserve(int vertexCount, int edgeCount) {
+    vertices.reserve(vertexCount);
+    degrees.reserve(vertexCount);
+    oddSlot.reserve(vertexCount);
+    vertexToEdgeIds.reserve(vertexCount);
+    edges.reserve(edgeCount);
+    nextParallel.reserve(edgeCount);
+    pairToEdge.reserve(edgeCount);
+}
+
+void Graph::adoptEdges(std::vector<Edge> &&list) {
+    edges = std::move(list);
+    removedEdges = 0;
+    rebuildDegrees();
+    // size every incidence list from its degree, then fill them in one pass
     vertexToEdgeIds.clear();
-    for (const auto &edge : edges) {
-        if (edge.id == edgeId) continue;
-        Edge copy = edge;
-        copy.id = static_cast<int>(newEdges.size());
-        newEdges.push_back(copy);
-        vertexToEdgeIds[copy.u].push_back(copy.id);
-        vertexToEdgeIds[copy.v].push_back(copy.id);
+    vertexToEdgeIds.reserve(vertices.size());
+    for (int v = 0; v < static_cast<int>(degrees.size()); ++v) {
+        if (degrees[v] > 0) vertexToEdgeIds[v].reserve(degrees[v]);
     }
-    edges.swap(newEdges);
+    for (int id = 0; id < static_cast<int>(edges.size()); ++id) {
+        vertexToEdgeIds[edges[id].u].push_back(id);
+        vertexToEdgeIds[edges[id].v].push_back(id);
+    }
+    rebuildEdgeIndex();
+    componentsStale = true;
+    csrCache = std::make_shared<const CsrGraph>(static_cast<int>(vertices.size()), edges);
+    hierarchy.reset();
+}
+
+void Graph::removeEdge(int edgeId) {
+    if (edgeId < 0 || static_cast<size_t>(edgeId) >= edges.size() || edges[edgeId].removed) return;
+    Edge &e = edges[edgeId];
+    unindexEdge(edgeId);
+    // unhook from both incidence lists (a self-loop sits twice in one list)
+    for (int end : { e.u, e.v }) {
+        auto it = vertexToEdgeIds.find(end);
+        if (it == vertexToEdgeIds.end()) continue;
+        auto &ids = it->second;
+        ids.erase(std::remove(ids.begin(), ids.end(), edgeId), ids.end());
+        if (ids.empty()) vertexToEdgeIds.erase(it);
+    }
+    e.removed = true;
+    ++removedEdges;
+    addDegree(e.u, -1);
+    addDegree(e.v, -1);
+    componentsStale = true; // union-find cannot split
+    csrCache.reset();
+    hierarchy.reset();
 }
 
 void Graph::removeVertex(int vertexId) {
-    if (vertexId < 0 || static_cast<size_t>(vertexId) >= vertices.size()) return;
-    // remove edges incident to vertex
-    std::vector<Edge> filteredEdges;
-    filteredEdges.reserve(edges.size());
-    for (const auto &e : edges) {
-        if (e.u == vertexId || e.v == vertexId) continue;
-        filteredEdges.push_back(e);
-    }
-    // rebuild vertices with compact ids and remap edges
-    std::vector<int> oldToNew(vertices.size(), -1);
+    if (!hasVertex(vertexId)) return;
+    // removeEdge shrinks the list under us, so re-read it and peel off the back
+    for (IncidentRange ids = incidentEdges(vertexId); !ids.empty(); ids = incidentEdges(vertexId))
+        removeEdge(*(ids.end() - 1));
+    vertices[vertexId].removed = true;
+    ++removedVertices;
+    componentsStale = true;
+    csrCache.reset();
+    hierarchy.reset();
+}
+
+IdRemap Graph::compact() {
+    IdRemap remap;
+    if (removedVertices == 0 && removedEdges == 0) return remap;
+    remap.vertices.assign(vertices.size(), -1);
+    remap.edges.assign(edges.size(), -1);
+
     std::vector<Vertex> newVerts;
-    newVerts.reserve(vertices.size() - 1);
-    for (const auto &v : vertices) {
-        if (v.id == vertexId) continue;
-        Vertex nv = v;
-        nv.id = static_cast<int>(newVerts.size());
-        oldToNew[v.id] = nv.id;
-        newVerts.push_back(nv);
+    newVerts.reserve(vertexCount());
+    for (size_t id = 0; id < vertices.size(); ++id) {
+        if (vertices[id].removed) continue;
+        remap.vertices[id] = static_cast<int>(newVerts.size());
+        newVerts.push_back(vertices[id]);
     }
     std::vector<Edge> newEdges;
-    newEdges.reserve(filteredEdges.size());
+    newEdges.reserve(edgeCount());
     vertexToEdgeIds.clear();
-    for (const auto &e : filteredEdges) {
+    for (size_t id = 0; id < edges.size(); ++id) {
+        const Edge &e = edges[id];
+        if (e.removed) continue;
         Edge ne = e;
-        ne.u = oldToNew[e.u];
-        ne.v = oldToNew[e.v];
-        ne.id = static_cast<int>(newEdges.size());
+        ne.u = remap.vertices[e.u];
+        ne.v = remap.vertices[e.v];
+        const int newId = static_cast<int>(newEdges.size());
+        remap.edges[id] = newId;
         newEdges.push_back(ne);
-        vertexToEdgeIds[ne.u].push_back(ne.id);
-        vertexToEdgeIds[ne.v].push_back(ne.id);
+        vertexToEdgeIds[ne.u].push_back(newId);
+        vertexToEdgeIds[ne.v].push_back(newId);
     }
     vertices.swap(newVerts);
     edges.swap(newEdges);
+    removedVertices = 0;
+    removedEdges = 0;
+    rebuildEdgeIndex();
+    rebuildDegrees();
+    componentsStale = true;
+    csrCache.reset();
+    hierarchy.reset();
+    return remap;
 }
 
-std::vector<int> Graph::neighbors(int u) const {
-    std::vector<int> nbs;
-    auto it = vertexToEdgeIds.find(u);
-    if (it == vertexToEdgeIds.end()) return nbs;
-    for (int eid : it->second) {
-        const Edge &e = edges[eid];
-        int w = (e.u == u ? e.v : e.u);
-        nbs.push_back(w);
+IdRemap Graph::compactIfSparse() {
+    const size_t dead = static_cast<size_t>(removedVertices) + removedEdges;
+    if (dead == 0 || dead * 2 < vertices.size() + edges.size()) return {};
+    return compact();
+}
+
+int Graph::findEdge(int u, int v) const {
+    auto it = pairToEdge.find(pairKey(u, v));
+    if (it == pairToEdge.end()) return -1;
+    for (int id = it->second; id >= 0; id = nextParallel[id]) {
+        const Edge &e = edges[id];
+        // a directed edge only runs one way
+        if (!e.directed || (e.u == u && e.v == v)) return id;
     }
-    return nbs;
+    return -1;
 }
 
-int Graph::degree(int u) const {
-    auto it = vertexToEdgeIds.find(u);
-    if (it == vertexToEdgeIds.end()) return 0;
-    return static_cast<int>(it->second.size());
+int Graph::findParallel(int u, int v, bool directed) const {
+    auto it = pairToEdge.find(pairKey(u, v));
+    if (it == pairToEdge.end()) return -1;
+    for (int id = it->second; id >= 0; id = nextParallel[id]) {
+        const Edge &e = edges[id];
+        if (e.directed != directed) continue;
+        if (!directed || (e.u == u && e.v == v)) return id;
+    }
+    return -1;
 }
 
-bool Graph::isConnectedUndirected() const {
-    if (vertices.empty()) return true;
-    // Find a vertex with non-zero degree to start
-    int start = -1;
-    for (const auto &v : vertices) {
-        if (degree(v.id) > 0) { start = v.id; break; }
-    }
-    if (start == -1) return true; // no edges
-
-    std::vector<bool> visited(vertices.size(), false);
-    std::queue<int> q;
-    q.push(start);
-    visited[start] = true;
-    while (!q.empty()) {
-        int u = q.front(); q.pop();
-        for (int w : neighbors(u)) {
-            if (!visited[w]) { visited[w] = true; q.push(w); }
-        }
+void Graph::unindexEdge(int edgeId) {
+    auto it = pairToEdge.find(pairKey(edges[edgeId].u, edges[edgeId].v));
+    if (it == pairToEdge.end()) return;
+    if (it->second == edgeId) {
+        if (nextParallel[edgeId] >= 0) it->second = nextParallel[edgeId];
+        else pairToEdge.erase(it);
+    } else {
+        int prev = it->second;
+        while (nextParallel[prev] >= 0 && nextParallel[prev] != edgeId) prev = nextParallel[prev];
+        if (nextParallel[prev] == edgeId) nextParallel[prev] = nextParallel[edgeId];
     }
+    nextParallel[edgeId] = -1;
+}
+
+void Graph::indexEdge(int edgeId) {
+    const Edge &e = edges[edgeId];
+    if (static_cast<size_t>(edgeId) >= nextParallel.size()) nextParallel.resize(edgeId + 1, -1);
+    auto [it, inserted] = pairToEdge.try_emplace(pairKey(e.u, e.v), edgeId);
+    // new edges go to the head of their pair's chain
+    nextParallel[edgeId] = inserted ? -1 : it->second;
+    it->second = edgeId;
+}
 
-    // Check all vertices with non-zero degree were visited
-    for (const auto &v : vertices) {
-        if (degree(v.id) > 0 && !visited[v.id]) return false;
+void Graph::rebuildEdgeIndex() {
+    pairToEdge.clear();
+    pairToEdge.reserve(edges.size());
+    nextParallel.assign(edges.size(), -1);
+    for (int id = 0; id < static_cast<int>(edges.size()); ++id) {
+        if (!edges[id].removed) indexEdge(id);
     }
-    return true;
 }
 
-void Graph::dfs(int startVertex, std::vector<bool>& visited) const {
-    visited[startVertex] = true;
-    // Process the vertex (for example, print it)
-    // std::cout << "Visited: " << vertices[startVertex].label.toStdString() << std::endl;
+void Graph::addDegree(int v, int delta) {
+    if (v < 0 || static_cast<size_t>(v) >= degrees.size()) return;
+    degrees[v] += delta;
+    // every change is +-1, so parity flips each time
+    if (oddSlot[v] < 0) {
+        oddSlot[v] = static_cast<int>(odd.size());
+        odd.push_back(v);
+    } else {
+        int last = odd.back();
+        odd[oddSlot[v]] = last;
+        oddSlot[last] = oddSlot[v];
+        odd.pop_back();
+        oddSlot[v] = -1;
+    }
+}
 
-    for (int neighbor : neighbors(startVertex)) {
-        if (!visited[neighbor]) {
-            dfs(neighbor, visited);
+void Graph::rebuildDegrees() {
+    degrees.assign(vertices.size(), 0);
+    for (const auto &e : liveEdges()) {
+        if (e.u >= 0 && static_cast<size_t>(e.u) < degrees.size()) ++degrees[e.u];
+        if (e.v >= 0 && static_cast<size_t>(e.v) < degrees.size()) ++degrees[e.v];
+    }
+    odd.clear();
+    oddSlot.assign(vertices.size(), -1);
+    for (int v = 0; v < static_cast<int>(degrees.size()); ++v) {
+        if (degrees[v] % 2 == 1) {
+            oddSlot[v] = static_cast<int>(odd.size());
+            odd.push_back(v);
         }
     }
 }
 
-bool Graph::isConnectedDirected() const {
-    if (vertices.empty()) return true;
+void Graph::linkComponents(int u, int v) const {
+    if (u < 0 || v < 0 || u >= components.size() || v >= components.size()) return;
+    int ru = components.find(u), rv = components.find(v);
+    if (ru == rv) {
+        if (!edgeful[ru]) { edgeful[ru] = 1; ++edgefulComponents; }
+        return;
+    }
+    edgefulComponents -= edgeful[ru] + edgeful[rv];
+    int root = components.unite(ru, rv);
+    edgeful[root] = 1;
+    ++edgefulComponents;
+    --componentTotal;
+}
 
-    std::vector<bool> visited(vertices.size(), false);
-    int startVertex = 0; // Let's start with vertex 0
+void Graph::refreshComponents() const {
+    if (!componentsStale) return;
+    components.reset(static_cast<int>(vertices.size()));
+    edgeful.assign(vertices.size(), 0);
+    componentTotal = vertexCount();
+    edgefulComponents = 0;
+    for (const auto &e : liveEdges()) linkComponents(e.u, e.v);
+    componentsStale = false;
+}
 
-    dfs(startVertex, visited);
+QString Graph::vertexName(int id) const {
+    if (id < 0 || static_cast<size_t>(id) >= vertices.size()) return {};
+    const int label = vertices[id].label;
+    return label >= 0 ? namePool[label] : indexToLetters(~label);
+}
 
-    // Check if all vertices were visited
-    for (bool v : visited) {
-        if (!v) return false;
-    }
+const CsrGraph& Graph::csr() const {
+    if (!csrCache) csrCache = std::make_shared<const CsrGraph>(static_cast<int>(vertices.size()), edges);
+    return *csrCache;
+}
+
+bool Graph::attachContractionHierarchy(std::shared_ptr<const ContractionHierarchy> index) {
+    if (index && !index->matches(*this)) return false;
+    hierarchy = std::move(index);
     return true;
 }
 
+IncidentRange Graph::incidentEdges(int u) const {
+    auto it = vertexToEdgeIds.find(u);
+    if (it == vertexToEdgeIds.end()) return {};
+    const std::vector<int> &ids = it->second;
+    return IncidentRange(ids.data(), ids.data() + ids.size());
+}
+
+std::vector<int> Graph::neighbors(int u) const {
+    NeighborRange range = neighborRange(u);
+    std::vector<int> nbs;
+    nbs.reserve(range.size());
+    for (int w : range) nbs.push_back(w);
+    return nbs;
+}
+
+bool Graph::isConnectedUndirected() const {
+    refreshComponents();
+    return edgefulComponents <= 1;
+}
+
+int Graph::componentCount() const {
+    refreshComponents();
+    return componentTotal;
+}
 
+bool Graph::sameComponent(int u, int v) const {
+    if (!hasVertex(u) || !hasVertex(v)) return false;
+    refreshComponents();
+    return components.find(u) == components.find(v);
+}
+
+void Graph::dfs(int startVertex, std::vector<bool>& visited) const {
+    // explicit stack: a recursive walk overflows on long chains
+    std::vector<int> stack{startVertex};
+    visited[startVertex] = true;
+    while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        for (int neighbor : neighborRange(u)) {
+            if (!visited[neighbor]) {
+                visited[neighbor] = true;
+                stack.push_back(neighbor);
+            }
+        }
+    }
+}
+
+bool Graph::isConnectedDirected() const {
+    if (vertexCount() == 0) return true;
+    // strongly connected: every vertex with edges reaches every other along edge directions
+    std::vector<int> componentOf;
+    StrongComponents::Workspace ws;
+    StrongComponents::compute(*this, componentOf, ws);
+    int shared = -1;
+    for (int v = 0; v < static_cast<int>(componentOf.size()); ++v) {
+        if (componentOf[v] < 0 || degree(v) == 0) continue;
+        if (shared < 0) shared = componentOf[v];
+        else if (componentOf[v] != shared) return false;
+    }
+    return true;
+}
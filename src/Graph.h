@@ -4,61 +4,264 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <QHash>
 #include <QString>
 #include <QPointF>
+#include "UnionFind.h"
 
+// Storage precision. EULER_COMPACT_STORAGE keeps weights and coordinates as
+// floats, halving them for multi-million-segment road networks; the solvers
+// still compute in double either way.
+#ifdef EULER_COMPACT_STORAGE
+using EdgeWeight = float;
+
+// QPointF-compatible position held as two floats.
+class VertexPoint {
+public:
+    VertexPoint() = default;
+    VertexPoint(const QPointF &p) : px(static_cast<float>(p.x())), py(static_cast<float>(p.y())) {}
+    operator QPointF() const { return QPointF(px, py); }
+    double x() const { return px; }
+    double y() const { return py; }
+
+private:
+    float px{0.0f};
+    float py{0.0f};
+};
+#else
+using EdgeWeight = double;
+using VertexPoint = QPointF;
+#endif
+
+// A vertex's id is its slot index in Graph::getVertices(); it is not stored.
 struct Vertex {
-    int id;
-    QString name;
-    QPointF position; // for GUI placement
+    int label;            // >= 0: index into the graph's name pool; < 0: generated name ~label
+    VertexPoint position; // for GUI placement
+    bool removed{false};  // tombstone: the slot keeps its id until compact()
 };
 
+class CsrGraph;
+class ContractionHierarchy;
+
+// Like vertices, an edge's id is its slot index in Graph::getEdges().
 struct Edge {
-    int id;
     int u;
     int v;
-    double weight; // e.g., length
+    EdgeWeight weight; // e.g., length
     bool directed{false};
+    bool removed{false}; // tombstone, skipped by csr() and liveEdges()
+};
+
+// Forward range over a slot array that skips tombstoned entries.
+template <typename T>
+class LiveRange {
+public:
+    class iterator {
+    public:
+        iterator(const T *from, const T *stop) : at(from), end(stop) { skip(); }
+        const T& operator*() const { return *at; }
+        const T* operator->() const { return at; }
+        iterator& operator++() { ++at; skip(); return *this; }
+        bool operator!=(const iterator &o) const { return at != o.at; }
+        bool operator==(const iterator &o) const { return at == o.at; }
+    private:
+        void skip() { while (at != end && at->removed) ++at; }
+        const T *at;
+        const T *end;
+    };
+
+    explicit LiveRange(const std::vector<T> &slots) : first(slots.data()), last(slots.data() + slots.size()) {}
+    iterator begin() const { return iterator(first, last); }
+    iterator end() const { return iterator(last, last); }
+
+private:
+    const T *first;
+    const T *last;
+};
+
+// Non-owning view of one vertex's incident edge ids (a self-loop appears
+// twice). Like any iterator into the graph it is invalidated by the next edit.
+class IncidentRange {
+public:
+    IncidentRange() = default;
+    IncidentRange(const int *from, const int *to) : first(from), last(to) {}
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    int size() const { return static_cast<int>(last - first); }
+    bool empty() const { return first == last; }
+
+private:
+    const int *first{nullptr};
+    const int *last{nullptr};
+};
+
+// The opposite endpoint of each incident edge, resolved while iterating, so
+// walking a vertex's neighbors allocates nothing.
+class NeighborRange {
+public:
+    class iterator {
+    public:
+        iterator(const int *from, const Edge *slots, int vertex) : at(from), edges(slots), u(vertex) {}
+        int operator*() const { const Edge &e = edges[*at]; return e.u == u ? e.v : e.u; }
+        int edgeId() const { return *at; }
+        iterator& operator++() { ++at; return *this; }
+        bool operator!=(const iterator &o) const { return at != o.at; }
+        bool operator==(const iterator &o) const { return at == o.at; }
+    private:
+        const int *at;
+        const Edge *edges;
+        int u;
+    };
+
+    NeighborRange(IncidentRange incident, const Edge *slots, int vertex) : ids(incident), edges(slots), u(vertex) {}
+    iterator begin() const { return iterator(ids.begin(), edges, u); }
+    iterator end() const { return iterator(ids.end(), edges, u); }
+    int size() const { return ids.size(); }
+
+private:
+    IncidentRange ids;
+    const Edge *edges;
+    int u;
+};
+
+// Old id -> new id tables produced by Graph::compact(); -1 marks a dropped
+// entry. Both are empty when compaction had nothing to do.
+struct IdRemap {
+    std::vector<int> vertices;
+    std::vector<int> edges;
+    bool empty() const { return vertices.empty() && edges.empty(); }
+};
+
+// What addEdge does when an edge with the same endpoints (and direction, for
+// directed edges) already exists.
+enum class DuplicateEdgePolicy {
+    AllowMulti, // add a parallel edge, as the postman augmentation needs
+    Reject,     // keep the existing edge and return -1
+    MergeMin    // keep the existing edge with the smaller weight, return its id
 };
 
 class Graph {
 public:
     int addVertex(const QPointF &pos, const QString &name = {});
-    int addEdge(int u, int v, double weight = 1.0, bool directed = false);
+    int addEdge(int u, int v, double weight = 1.0, bool directed = false,
+                DuplicateEdgePolicy policy = DuplicateEdgePolicy::AllowMulti);
     void clear();
+    // Sizes the containers ahead of a known number of additions.
+    void reserve(int vertexCount, int edgeCount);
+    // Deletion tombstones the slot in O(degree) and keeps every other id stable;
+    // removing a vertex also removes its incident edges.
     void removeVertex(int vertexId);
     void removeEdge(int edgeId);
+    // Drops all tombstones and renumbers the survivors densely in O(V+E).
+    IdRemap compact();
+    // compact() once tombstones make up at least half of the slots, otherwise
+    // a no-op returning an empty remap. Callers holding ids must apply the remap.
+    IdRemap compactIfSparse();
 
+    // Slot arrays indexed by id, tombstones included (check Vertex/Edge::removed)
     const std::vector<Vertex>& getVertices() const { return vertices; }
     const std::vector<Edge>& getEdges() const { return edges; }
+    // The same arrays with tombstones skipped
+    LiveRange<Vertex> liveVertices() const { return LiveRange<Vertex>(vertices); }
+    LiveRange<Edge> liveEdges() const { return LiveRange<Edge>(edges); }
+    int vertexCount() const { return static_cast<int>(vertices.size()) - removedVertices; }
+    int edgeCount() const { return static_cast<int>(edges.size()) - removedEdges; }
+    bool hasVertex(int id) const { return id >= 0 && static_cast<size_t>(id) < vertices.size() && !vertices[id].removed; }
+    // Ids of records obtained from this graph (e.g. while iterating liveEdges())
+    int idOf(const Vertex &v) const { return static_cast<int>(&v - vertices.data()); }
+    int idOf(const Edge &e) const { return static_cast<int>(&e - edges.data()); }
+    // Display name: the interned custom name, or the generated A, B, ..., AA
+    // label fixed when the vertex was added (it survives compaction).
+    QString vertexName(int id) const;
 
     std::vector<int> neighbors(int u) const; // returns neighbor vertex ids (for undirected)
-    int degree(int u) const;
-    bool isConnectedUndirected() const;
+    // Allocation-free views over u's incidence list; prefer these in traversals.
+    IncidentRange incidentEdges(int u) const;
+    NeighborRange neighborRange(int u) const { return NeighborRange(incidentEdges(u), edges.data(), u); }
+    // Degrees and the odd-degree set are kept up to date by every edit, so
+    // these are O(1). oddVertices() is unordered: entries move on removal.
+    int degree(int u) const { return u >= 0 && static_cast<size_t>(u) < degrees.size() ? degrees[u] : 0; }
+    const std::vector<int>& oddVertices() const { return odd; }
+    int oddVertexCount() const { return static_cast<int>(odd.size()); }
+    // Id of an edge joining u and v (either way round for undirected edges),
+    // or -1; O(1) expected through the endpoint-pair index.
+    int findEdge(int u, int v) const;
+    // Undirected connectivity from a union-find merged on every addEdge; a
+    // deletion marks it stale and the next query rebuilds it in O(V+E).
+    bool isConnectedUndirected() const; // all vertices with edges in one component
+    int componentCount() const;         // over live vertices, isolated ones included
+    bool sameComponent(int u, int v) const;
+    // Marks everything reachable from startVertex, ignoring edge direction;
+    // iterative, O(V+E).
     void dfs(int startVertex, std::vector<bool>& visited) const; // th�m khai b�o n�y
+    // Strong connectivity of all vertices with edges, honouring directed edges;
+    // isolated vertices are ignored as in isConnectedUndirected (see
+    // StrongComponents::compute for the component ids themselves).
     bool isConnectedDirected() const; // th�m khai b�o n�y
 
     // adjacency list by vertex id -> edge indices
     const std::unordered_map<int, std::vector<int>>& adjacency() const { return vertexToEdgeIds; }
 
+    // Packed CSR snapshot of the adjacency, built in O(V+E) on first use and
+    // reused until the next structural edit. Solvers scan this instead of adjacency().
+    const CsrGraph& csr() const;
+
+    // Optional contraction-hierarchy index for repeated shortest-path queries.
+    // Never built implicitly (preprocessing is costly): attach one built or loaded
+    // for this graph; it is refused if its fingerprint differs and dropped on the
+    // next structural edit. nullptr when none is attached.
+    const ContractionHierarchy* contractionHierarchy() const { return hierarchy.get(); }
+    bool attachContractionHierarchy(std::shared_ptr<const ContractionHierarchy> index);
+
 private:
+    friend class GraphBuilder;
+
     std::vector<Vertex> vertices;
     std::vector<Edge> edges;
+    // custom vertex names, each stored once; Vertex::label indexes it
+    std::vector<QString> namePool;
+    QHash<QString, int> nameIndex;
     std::unordered_map<int, std::vector<int>> vertexToEdgeIds;
+    mutable std::shared_ptr<const CsrGraph> csrCache; // immutable, so copies may share it
+    std::shared_ptr<const ContractionHierarchy> hierarchy;
+    // Endpoint-pair index: unordered pair key -> first edge with those ends;
+    // further edges on the same pair chain through nextParallel (by edge id).
+    std::unordered_map<std::uint64_t, int> pairToEdge;
+    std::vector<int> nextParallel;
+    int removedVertices{0};
+    int removedEdges{0};
+    // degree per vertex slot; odd lists the odd-degree vertices and
+    // oddSlot[v] is v's position in it, or -1
+    std::vector<int> degrees;
+    std::vector<int> odd;
+    std::vector<int> oddSlot;
+    // edgeful[r] marks union-find roots whose component holds an edge
+    mutable UnionFind components;
+    mutable std::vector<char> edgeful;
+    mutable int componentTotal{0};
+    mutable int edgefulComponents{0};
+    mutable bool componentsStale{false};
 
-    bool hasEdge(int u, int v) const {
-        if (u < 0 || v < 0 || static_cast<size_t>(u) >= vertices.size() || static_cast<size_t>(v) >= vertices.size()) 
-            return false;
-        
-        // Check both directions since the graph is undirected
-        for (int edgeId : vertexToEdgeIds.at(u)) {
-            const Edge& e = edges[edgeId];
-            if ((e.u == u && e.v == v) || (e.u == v && e.v == u)) {
-                return true;
-            }
-        }
-        return false;
+    static std::uint64_t pairKey(int u, int v) {
+        if (u > v) std::swap(u, v);
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(u)) << 32) | static_cast<std::uint32_t>(v);
     }
+    int findParallel(int u, int v, bool directed) const;
+    void indexEdge(int edgeId);
+    void unindexEdge(int edgeId);
+    void rebuildEdgeIndex();
+    void addDegree(int v, int delta);
+    void rebuildDegrees();
+    // Replaces all edges with list and builds every index from it in linear
+    // passes (the bulk path behind GraphBuilder).
+    void adoptEdges(std::vector<Edge> &&list);
+    void linkComponents(int u, int v) const;
+    void refreshComponents() const;
+
+    bool hasEdge(int u, int v) const { return findEdge(u, v) >= 0; }
 };
 
 
@@ -0,0 +1,70 @@
+#include "GraphBuilder.h"
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+GraphBuilder::GraphBuilder(DuplicateEdgePolicy duplicates, bool sortByEndpoint)
+    : duplicates(duplicates), sortByEndpoint(sortByEndpoint) {}
+
+void GraphBuilder::reserve(int vertexCount, int edgeCount) {
+    graph.reserve(vertexCount, edgeCount);
+    pending.reserve(edgeCount);
+}
+
+int GraphBuilder::addVertex(const QPointF &pos, const QString &name) {
+    return graph.addVertex(pos, name);
+}
+
+bool GraphBuilder::addEdge(int u, int v, double weight, bool directed) {
+    const int n = vertexCount();
+    if (u < 0 || v < 0 || u >= n || v >= n) return false;
+    pending.push_back(Edge{ u, v, static_cast<EdgeWeight>(weight), directed });
+    return true;
+}
+
+Graph GraphBuilder::build() {
+    const bool dedup = duplicates != DuplicateEdgePolicy::AllowMulti;
+    if (dedup || sortByEndpoint) {
+        // Sort an index permutation so equal keys keep insertion order: Reject
+        // then keeps the first copy and MergeMin keeps the first slot.
+        auto key = [](const Edge &e) {
+            // a directed edge only matches its own orientation
+            return std::make_tuple(std::min(e.u, e.v), std::max(e.u, e.v), e.directed, e.directed ? e.u : 0);
+        };
+        std::vector<int> order(pending.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key(pending[a]) < key(pending[b]); });
+
+        std::vector<char> keep(pending.size(), 1);
+        if (dedup) {
+            for (size_t i = 0; i < order.size();) {
+                size_t j = i + 1;
+                Edge &first = pending[order[i]];
+                for (; j < order.size() && key(pending[order[j]]) == key(first); ++j) {
+                    keep[order[j]] = 0;
+                    if (duplicates == DuplicateEdgePolicy::MergeMin)
+                        first.weight = std::min(first.weight, pending[order[j]].weight);
+                }
+                i = j;
+            }
+        }
+
+        std::vector<Edge> kept;
+        kept.reserve(pending.size());
+        if (sortByEndpoint) {
+            for (int id : order)
+                if (keep[id]) kept.push_back(pending[id]);
+        } else {
+            for (size_t id = 0; id < pending.size(); ++id)
+                if (keep[id]) kept.push_back(pending[id]);
+        }
+        pending.swap(kept);
+    }
+
+    graph.adoptEdges(std::move(pending));
+    pending = {};
+    Graph result = std::move(graph);
+    graph = Graph();
+    return result;
+}
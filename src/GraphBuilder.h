@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Graph.h"
+#include <vector>
+
+// Bulk construction for imports: vertices go straight into the graph, edges
+// are buffered and handed over in build(), which optionally drops duplicates
+// and sorts by endpoint, then lays out the incidence lists (sized exactly from
+// a degree count), the endpoint-pair index, the degree/parity counters and the
+// CSR snapshot in linear passes instead of E incremental addEdge calls.
+class GraphBuilder {
+public:
+    // duplicates applies to the buffered edges the way addEdge applies it;
+    // sortByEndpoint orders the edges by (smaller, larger) endpoint, which also
+    // groups parallel streets and makes incidence scans more cache-friendly.
+    explicit GraphBuilder(DuplicateEdgePolicy duplicates = DuplicateEdgePolicy::AllowMulti,
+                          bool sortByEndpoint = false);
+
+    void reserve(int vertexCount, int edgeCount);
+    int addVertex(const QPointF &pos, const QString &name = {});
+    int vertexCount() const { return static_cast<int>(graph.getVertices().size()); }
+    // false (and nothing buffered) when an endpoint is not a vertex yet
+    bool addEdge(int u, int v, double weight = 1.0, bool directed = false);
+    // Any range whose elements have u, v, weight and directed members, e.g. Edge.
+    template <typename It>
+    int addEdges(It first, It last) {
+        int added = 0;
+        for (; first != last; ++first) added += addEdge(first->u, first->v, first->weight, first->directed);
+        return added;
+    }
+
+    // Returns the finished graph and leaves the builder empty.
+    Graph build();
+
+private:
+    Graph graph;
+    std::vector<Edge> pending;
+    DuplicateEdgePolicy duplicates;
+    bool sortByEndpoint;
+};
@@ -5,18 +5,6 @@
 
 static constexpr double VERTEX_RADIUS = 10.0;
 
-// Convert 0-based index to alphabetical label: A, B, C, ..., Z, AA, AB, ...
-static QString indexToLetters(int index) {
-    QString s;
-    int i = index;
-    do {
-        int r = i % 26;
-        s.prepend(QChar('A' + r));
-        i = i / 26 - 1;
-    } while (i >= 0);
-    return s;
-}
-
 GraphCanvas::GraphCanvas(QWidget *parent) : QWidget(parent) {
     setMouseTracking(true);
     setAutoFillBackground(true);
@@ -29,22 +17,29 @@ void GraphCanvas::setRoute(const std::vector<int>& edgeOrder) {
 
 void GraphCanvas::clearRoute() {
     routeEdgeOrder.clear();
+    searcher.reset();
     update();
 }
 
+void GraphCanvas::setMode(Mode m) {
+    mode = m;
+    routeFrom = -1;
+    searcher.reset();
+}
+
 int GraphCanvas::hitTestVertex(const QPointF &p) const {
-    for (const auto &v : graph.getVertices()) {
-        if (QLineF(p, v.position).length() <= VERTEX_RADIUS + 3) return v.id;
+    for (const auto &v : graph.liveVertices()) {
+        if (QLineF(p, v.position).length() <= VERTEX_RADIUS + 3) return graph.idOf(v);
     }
     return -1;
 }
 
 int GraphCanvas::hitTestEdge(const QPointF &p, int *outU, int *outV, double threshold) const {
-    const auto &edges = graph.getEdges();
     const auto &verts = graph.getVertices();
+    // scan the edge slots in place, no per-click snapshot
     int foundId = -1;
     double bestDist = threshold;
-    for (const auto &e : edges) {
+    for (const auto &e : graph.liveEdges()) {
         if (e.u < 0 || static_cast<size_t>(e.u) >= verts.size() || e.v < 0 || static_cast<size_t>(e.v) >= verts.size()) continue;
         QLineF line(verts[e.u].position, verts[e.v].position);
         // distance from point to segment
@@ -59,7 +54,7 @@ int GraphCanvas::hitTestEdge(const QPointF &p, int *outU, int *outV, double thre
         double dist = QLineF(p, proj).length();
         if (dist <= bestDist) {
             bestDist = dist;
-            foundId = e.id;
+            foundId = graph.idOf(e);
             if (outU) *outU = e.u;
             if (outV) *outV = e.v;
         }
@@ -79,7 +74,7 @@ void GraphCanvas::paintEvent(QPaintEvent*) {
     // draw edges
     QPen edgePen(QColor(80,80,80)); edgePen.setWidth(2);
     painter.setPen(edgePen);
-    for (const auto &e : graph.getEdges()) {
+    for (const auto &e : graph.liveEdges()) {
         const auto &u = graph.getVertices()[e.u];
         const auto &v = graph.getVertices()[e.v];
         painter.drawLine(u.position, v.position);
@@ -94,6 +89,7 @@ void GraphCanvas::paintEvent(QPaintEvent*) {
         for (int eid : routeEdgeOrder) {
             if (eid < 0 || static_cast<size_t>(eid) >= edges.size()) continue;
             const auto &e = edges[eid];
+            if (e.removed) continue;
             if (e.u < 0 || static_cast<size_t>(e.u) >= verts.size() ||
                 e.v < 0 || static_cast<size_t>(e.v) >= verts.size()) continue;
             const auto &u = verts[e.u];
@@ -107,30 +103,30 @@ void GraphCanvas::paintEvent(QPaintEvent*) {
     QFont edgeFont = painter.font();
     edgeFont.setPointSizeF(std::max(15.0, edgeFont.pointSizeF() * 1.5));
     painter.setFont(edgeFont);
-    for (const auto &e : graph.getEdges()) {
+    for (const auto &e : graph.liveEdges()) {
         const auto &u = graph.getVertices()[e.u];
         const auto &v = graph.getVertices()[e.v];
         QPointF mid((u.position.x() + v.position.x()) * 0.5, (u.position.y() + v.position.y()) * 0.5);
-        QPointF d = v.position - u.position;
+        QPointF d = QPointF(v.position) - QPointF(u.position);
         double len = std::hypot(d.x(), d.y());
         QPointF n = (len > 0.0) ? QPointF(-d.y() / len, d.x() / len) : QPointF(0.0, -1.0);
         QPointF pos = mid + n * 10.0;
         QRectF r(pos.x() - 14, pos.y() - 14, 28, 28);
-        painter.drawText(r, Qt::AlignCenter, QString::number(e.id + 1));
+        painter.drawText(r, Qt::AlignCenter, QString::number(graph.idOf(e) + 1));
     }
 
     // draw vertices (circles) and their labels (A, B, C, ...)
     QFont vertexFont = painter.font();
     vertexFont.setPointSizeF(16);
     painter.setFont(vertexFont);
-    for (const auto &v : graph.getVertices()) {
+    for (const auto &v : graph.liveVertices()) {
         // Draw vertex circle
         painter.setBrush(Qt::white);
         painter.setPen(QPen(Qt::black, 2));
         painter.drawEllipse(v.position, VERTEX_RADIUS, VERTEX_RADIUS);
         // Draw label (A, B, C, ...) ph�a tr�n ??nh
         painter.setPen(Qt::black);
-        QString label = v.name.isEmpty() ? indexToLetters(v.id) : v.name;
+        QString label = graph.vertexName(graph.idOf(v));
         // D?ch label l�n tr�n h�nh tr�n, kh�ng ??ng v�o vertex
         QRectF textRect(v.position.x() - VERTEX_RADIUS, v.position.y() - VERTEX_RADIUS - 28, VERTEX_RADIUS*2, VERTEX_RADIUS*2);
         painter.drawText(textRect, Qt::AlignHCenter | Qt::AlignBottom, label);
@@ -155,7 +151,7 @@ void GraphCanvas::mousePressEvent(QMouseEvent *event) {
                     emit statusMessage("Select second vertex");
                 } else if (v != pendingEdgeFrom) {  // Prevent self-loops
                     // Only add edge if it doesn't already exist
-                    int edgeId = graph.addEdge(pendingEdgeFrom, v);
+                    int edgeId = graph.addEdge(pendingEdgeFrom, v, 1.0, false, DuplicateEdgePolicy::Reject);
                     if (edgeId >= 0) {
                         emit statusMessage("Added edge");
                     } else {
@@ -171,11 +167,34 @@ void GraphCanvas::mousePressEvent(QMouseEvent *event) {
             draggingVertex = hitTestVertex(pos);
             break;
         }
+        case ShortestRoute: {
+            int v = hitTestVertex(pos);
+            if (v < 0) break;
+            if (routeFrom < 0) {
+                routeFrom = v;
+                emit statusMessage("Select destination vertex");
+                break;
+            }
+            // Hiệu chỉnh heuristic một lần (O(E)), các truy vấn sau chỉ chạm phần nhỏ của đồ thị
+            if (!searcher) searcher = std::make_unique<ShortestPath::PointToPoint>(graph);
+            ShortestPath::Route r = searcher->query(routeFrom, v, searcher->preferred());
+            QString from = graph.vertexName(routeFrom), to = graph.vertexName(v);
+            routeFrom = -1;
+            routeEdgeOrder = r.edges;
+            update();
+            if (!qIsFinite(r.length))
+                emit statusMessage(QString("No route from %1 to %2").arg(from, to));
+            else
+                emit statusMessage(QString("Shortest route %1 - %2: length %3 (%4 vertices searched)")
+                                       .arg(from, to).arg(r.length).arg(searcher->lastSettled()));
+            break;
+        }
         case Eraser: {
             // Ưu tiên xóa đỉnh nếu click trúng đỉnh, ngược lại thử xóa cạnh gần nhất
             int vId = hitTestVertex(pos);
             if (vId >= 0) {
                 graph.removeVertex(vId);
+                compactErased();
                 clearRoute();
                 update();
                 emit statusMessage("Deleted vertex");
@@ -185,6 +204,7 @@ void GraphCanvas::mousePressEvent(QMouseEvent *event) {
             int eId = hitTestEdge(pos, &u, &v);
             if (eId >= 0) {
                 graph.removeEdge(eId);
+                compactErased();
                 clearRoute();
                 update();
                 emit statusMessage("Deleted edge");
@@ -198,10 +218,19 @@ void GraphCanvas::mousePressEvent(QMouseEvent *event) {
     }
 }
 
+void GraphCanvas::compactErased() {
+    // Tombstones keep each erase O(degree); renumber only once they pile up
+    if (pendingEdgeFrom >= 0 && !graph.hasVertex(pendingEdgeFrom)) pendingEdgeFrom = -1;
+    IdRemap remap = graph.compactIfSparse();
+    if (remap.empty()) return;
+    if (pendingEdgeFrom >= 0) pendingEdgeFrom = remap.vertices[pendingEdgeFrom];
+    if (draggingVertex >= 0) draggingVertex = remap.vertices[draggingVertex];
+}
+
 void GraphCanvas::mouseMoveEvent(QMouseEvent *ev) {
     if (mode == MoveVertex && draggingVertex != -1) {
         auto &verts = const_cast<std::vector<Vertex>&>(graph.getVertices());
-        verts[draggingVertex].position = ev->pos();
+        verts[draggingVertex].position = ev->position();
         update();
     }
 }
@@ -5,6 +5,8 @@
 #include <QPen>
 #include <QImage>
 #include "Graph.h"
+#include "ShortestPath.h"
+#include <memory>
 
 class GraphCanvas : public QWidget {
     Q_OBJECT
@@ -19,8 +21,8 @@ public:
     void setBackgroundImage(const QImage &img) { backgroundImage = img; update(); }
     void clearBackgroundImage() { backgroundImage = QImage(); update(); }
 
-    enum Mode { AddVertex, AddEdge, MoveVertex, Eraser, None };
-    void setMode(Mode m) { mode = m; }
+    enum Mode { AddVertex, AddEdge, MoveVertex, Eraser, ShortestRoute, None };
+    void setMode(Mode m);
 
 signals:
     void statusMessage(const QString &msg);
@@ -37,8 +39,13 @@ private:
     Mode mode{AddVertex};
     int pendingEdgeFrom{-1};
     int draggingVertex{-1};
+    int routeFrom{-1};
+    // point-to-point searcher for ShortestRoute, kept across queries until the
+    // graph may have changed (mode switch or clearRoute)
+    std::unique_ptr<ShortestPath::PointToPoint> searcher;
     QImage backgroundImage;
 
+    void compactErased();
     int hitTestVertex(const QPointF &p) const;
     int hitTestEdge(const QPointF &p, int *outU = nullptr, int *outV = nullptr, double threshold = 6.0) const;
 };
@@ -0,0 +1,667 @@
+#include "GraphIO.h"
+#include "GraphBuilder.h"
+#include "ThreadPool.h"
+#include <QByteArray>
+#include <QFile>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// Bytes per parse chunk; smaller files are scanned on the calling thread.
+constexpr qint64 kChunkBytes = qint64(1) << 20;
+// An edge list names at most two vertices per line; ids may leave gaps (the
+// missing vertices become isolated) but not more than this many beyond 2E,
+// so a stray huge id is reported instead of allocating billions of vertices.
+constexpr long long kMaxIdGap = 1 << 20;
+
+// Read-only view of a whole file: mapped when the platform allows it,
+// otherwise read into memory (e.g. for pipes and some network shares).
+class MappedFile {
+public:
+    bool open(const QString &path) {
+        file.setFileName(path);
+        if (!file.open(QIODevice::ReadOnly)) return false;
+        const qint64 size = file.size();
+        if (size > 0) {
+            if (uchar *p = file.map(0, size)) {
+                first = reinterpret_cast<const char*>(p);
+                last = first + size;
+                return true;
+            }
+        }
+        copy = file.readAll();
+        first = copy.constData();
+        last = first + copy.size();
+        return true;
+    }
+    const char* begin() const { return first; }
+    const char* end() const { return last; }
+
+private:
+    QFile file; // the mapping lives as long as the file object
+    QByteArray copy;
+    const char *first{nullptr};
+    const char *last{nullptr};
+};
+
+inline bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == ',' || c == '\v' || c == '\f';
+}
+
+// Chunk boundaries over [begin, end), each moved forward to a line start so
+// no line is split; consecutive boundaries may coincide for very long lines.
+std::vector<const char*> lineChunks(const char *begin, const char *end) {
+    const qint64 size = end - begin;
+    const int pieces = static_cast<int>(std::min<qint64>(
+        std::max<qint64>(size / kChunkBytes, 1), ThreadPool::shared().workerCount() * 4));
+    std::vector<const char*> bounds{ begin };
+    for (int k = 1; k < pieces; ++k) {
+        const char *p = std::max(begin + size * k / pieces, bounds.back());
+        const void *nl = p < end ? std::memchr(p, '\n', static_cast<size_t>(end - p)) : nullptr;
+        bounds.push_back(nl ? static_cast<const char*>(nl) + 1 : end);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// Calls line(from, to) for each line in [begin, end), without the '\n'.
+template <typename LineFn>
+void forEachLine(const char *begin, const char *end, LineFn line) {
+    while (begin < end) {
+        const void *nl = std::memchr(begin, '\n', static_cast<size_t>(end - begin));
+        const char *stop = nl ? static_cast<const char*>(nl) : end;
+        line(begin, stop);
+        if (!nl) break;
+        begin = stop + 1;
+    }
+}
+
+// Next separator-delimited token of a line; false once the line is used up.
+inline bool nextToken(const char *&at, const char *end, const char *&tokenEnd) {
+    while (at < end && isSeparator(*at)) ++at;
+    if (at == end) return false;
+    tokenEnd = at;
+    while (tokenEnd < end && !isSeparator(*tokenEnd)) ++tokenEnd;
+    return true;
+}
+
+// Optionally signed decimal integer that fits an int; false otherwise.
+bool parseInt(const char *p, const char *end, int &out) {
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+    if (p == end) return false;
+    long long value = 0;
+    for (; p < end; ++p) {
+        const unsigned digit = static_cast<unsigned char>(*p) - '0';
+        if (digit > 9) return false;
+        value = value * 10 + digit;
+        if (value > INT_MAX) return false;
+    }
+    out = static_cast<int>(negative ? -value : value);
+    return true;
+}
+
+// Decimal number such as 12, -0.5 or 3.2e4. Up to 19 significant digits with
+// a small exponent are converted exactly by one multiply or divide by a power
+// of ten (both operands are exact doubles); anything else goes through Qt's
+// locale-independent conversion.
+bool parseDouble(const char *p, const char *end, double &out) {
+    static const double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char *start = p;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+    std::uint64_t mantissa = 0;
+    int digits = 0, scale = 0;
+    bool any = false;
+    for (; p < end && static_cast<unsigned char>(*p - '0') <= 9; ++p, any = true) {
+        if (mantissa || *p != '0') { mantissa = mantissa * 10 + (*p - '0'); ++digits; }
+        if (digits > 19) break;
+    }
+    if (p < end && *p == '.' && digits <= 19) {
+        for (++p; p < end && static_cast<unsigned char>(*p - '0') <= 9; ++p, any = true) {
+            if (mantissa || *p != '0') { mantissa = mantissa * 10 + (*p - '0'); ++digits; }
+            --scale;
+            if (digits > 19) break;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E') && any && digits <= 19) {
+        int exponent = 0;
+        if (parseInt(p + 1, end, exponent) && exponent > -400 && exponent < 400) {
+            scale += exponent;
+            p = end;
+        }
+    }
+    if (any && p == end && digits <= 19 && mantissa <= (std::uint64_t(1) << 53) && scale >= -22 && scale <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = scale < 0 ? value / kPow10[-scale] : value * kPow10[scale];
+        out = negative ? -value : value;
+        return true;
+    }
+    bool ok = false;
+    out = QByteArray::fromRawData(start, static_cast<int>(end - start)).toDouble(&ok);
+    return ok;
+}
+
+// Edge weight: a number that is finite and >= 0 once stored as EdgeWeight.
+// Shortest paths, the contraction hierarchy and the matcher all rely on it,
+// so "nan", "inf" and negative lengths are rejected rather than loaded.
+bool parseWeight(const char *p, const char *end, double &out) {
+    if (!parseDouble(p, end, out)) return false;
+    const EdgeWeight stored = static_cast<EdgeWeight>(out);
+    return std::isfinite(stored) && stored >= 0;
+}
+
+struct MatrixChunk {
+    std::vector<std::pair<int, int>> entries; // (row within chunk, column) of nonzeros
+    int rows{0};
+    int minWidth{INT_MAX};
+    int maxWidth{0};
+};
+
+struct EdgeListChunk {
+    std::vector<Edge> edges;
+    int maxVertex{-1};
+    bool malformed{false};
+};
+
+struct DimacsChunk {
+    std::vector<Edge> arcs; // 0-based, all marked directed until paired
+    int maxVertex{-1};
+    int vertexTotal{-1};    // from this chunk's "p" line, if it has one
+    long long arcTotal{-1};
+    int problemLines{0};
+    bool malformed{false};
+};
+
+struct MetisChunk {
+    std::vector<Edge> entries; // u = row within chunk, v = 0-based neighbor
+    int rows{0};
+    int lastFilledRow{-1};     // within chunk; blank rows past n are tolerated
+    bool malformed{false};
+};
+
+// Old slot -> dense output id for live vertices, -1 for tombstones.
+std::vector<int> denseIds(const Graph &g, int &count) {
+    const auto &vertices = g.getVertices();
+    std::vector<int> ids(vertices.size(), -1);
+    count = 0;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (!vertices[i].removed) ids[i] = count++;
+    }
+    return ids;
+}
+
+// Append-only text output flushed to the file in large blocks.
+class BufferedWriter {
+public:
+    bool open(const QString &path) {
+        file.setFileName(path);
+        buffer.reserve(kFlushBytes + 256);
+        return file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    void put(const char *text) { buffer.append(text); flushIfFull(); }
+    void put(char c) { buffer.append(c); }
+    void putInt(long long value) {
+        char digits[24];
+        char *p = digits + sizeof(digits);
+        const bool negative = value < 0;
+        unsigned long long rest = negative ? 0ull - static_cast<unsigned long long>(value) : value;
+        do { *--p = static_cast<char>('0' + rest % 10); rest /= 10; } while (rest);
+        if (negative) *--p = '-';
+        buffer.append(p, static_cast<int>(digits + sizeof(digits) - p));
+        flushIfFull();
+    }
+    // Integral weights as integers, otherwise the fewest significant digits
+    // that convert back to the same EdgeWeight.
+    void putWeight(EdgeWeight weight) {
+        const double w = weight;
+        if (w == std::floor(w) && std::fabs(w) < 1e15) {
+            putInt(static_cast<long long>(w));
+            return;
+        }
+        QByteArray text;
+        for (int digits : { std::numeric_limits<EdgeWeight>::digits10, std::numeric_limits<EdgeWeight>::max_digits10 }) {
+            text = QByteArray::number(w, 'g', digits);
+            if (static_cast<EdgeWeight>(text.toDouble()) == weight) break;
+        }
+        buffer.append(text);
+        flushIfFull();
+    }
+    bool finish() {
+        flush();
+        file.close();
+        return ok;
+    }
+
+private:
+    static constexpr int kFlushBytes = 1 << 20;
+    QFile file;
+    QByteArray buffer;
+    bool ok{true};
+
+    void flush() {
+        if (ok && !buffer.isEmpty()) ok = file.write(buffer) == buffer.size();
+        buffer.clear();
+    }
+    void flushIfFull() {
+        if (buffer.size() >= kFlushBytes) flush();
+    }
+};
+
+}
+
+namespace GraphIO {
+
+Status readAdjacencyMatrix(const QString &path, const Placement &place, Graph &out) {
+    MappedFile file;
+    if (!file.open(path)) return Status::CannotOpen;
+    const std::vector<const char*> bounds = lineChunks(file.begin(), file.end());
+    const int chunkCount = static_cast<int>(bounds.size()) - 1;
+
+    // Rows are numbered within their chunk here; the global row is only known
+    // once every chunk has counted its lines.
+    std::vector<MatrixChunk> chunks(chunkCount);
+    ThreadPool::shared().parallelFor(chunkCount, [&](int c, int) {
+        MatrixChunk &chunk = chunks[c];
+        forEachLine(bounds[c], bounds[c + 1], [&](const char *at, const char *end) {
+            int width = 0;
+            const char *tokenEnd = nullptr;
+            for (; nextToken(at, end, tokenEnd); at = tokenEnd, ++width) {
+                int value = 0;
+                // the global row is at least chunk.rows, so columns up to it
+                // are on or below the diagonal whatever the chunk's offset
+                if (width > chunk.rows && parseInt(at, tokenEnd, value) && value != 0)
+                    chunk.entries.emplace_back(chunk.rows, width);
+            }
+            if (width == 0) return; // blank line
+            ++chunk.rows;
+            chunk.minWidth = std::min(chunk.minWidth, width);
+            chunk.maxWidth = std::max(chunk.maxWidth, width);
+        });
+    });
+
+    int n = 0;
+    size_t nonzeros = 0;
+    for (const MatrixChunk &chunk : chunks) {
+        n += chunk.rows;
+        nonzeros += chunk.entries.size();
+    }
+    if (n == 0) return Status::NotSquare;
+    for (const MatrixChunk &chunk : chunks) {
+        if (chunk.rows && (chunk.minWidth != n || chunk.maxWidth != n)) return Status::NotSquare;
+    }
+
+    // A symmetric matrix lists each edge twice; half the nonzeros is the usual count
+    GraphBuilder builder;
+    builder.reserve(n, static_cast<int>(std::min<size_t>(nonzeros / 2 + 1, INT_MAX)));
+    for (int i = 0; i < n; ++i) builder.addVertex(place(i, n));
+    int firstRow = 0;
+    for (MatrixChunk &chunk : chunks) {
+        for (const auto &[row, column] : chunk.entries) {
+            if (column > firstRow + row) builder.addEdge(firstRow + row, column);
+        }
+        firstRow += chunk.rows;
+        std::vector<std::pair<int, int>>().swap(chunk.entries);
+    }
+    out = builder.build();
+    return Status::Ok;
+}
+
+Status readEdgeList(const QString &path, const Placement &place, Graph &out) {
+    MappedFile file;
+    if (!file.open(path)) return Status::CannotOpen;
+    const std::vector<const char*> bounds = lineChunks(file.begin(), file.end());
+    const int chunkCount = static_cast<int>(bounds.size()) - 1;
+
+    std::vector<EdgeListChunk> chunks(chunkCount);
+    ThreadPool::shared().parallelFor(chunkCount, [&](int c, int) {
+        EdgeListChunk &chunk = chunks[c];
+        forEachLine(bounds[c], bounds[c + 1], [&](const char *at, const char *end) {
+            if (chunk.malformed) return;
+            const char *tokenEnd = nullptr;
+            if (!nextToken(at, end, tokenEnd) || *at == '#' || *at == '%') return;
+            int u = -1, v = -1;
+            double weight = 1.0;
+            bool ok = parseInt(at, tokenEnd, u) && u >= 0 && u < INT_MAX - 1;
+            at = tokenEnd;
+            ok = ok && nextToken(at, end, tokenEnd) && parseInt(at, tokenEnd, v) && v >= 0 && v < INT_MAX - 1;
+            at = tokenEnd;
+            if (ok && nextToken(at, end, tokenEnd)) {
+                ok = parseWeight(at, tokenEnd, weight);
+                at = tokenEnd;
+                ok = ok && !nextToken(at, end, tokenEnd);
+            }
+            if (!ok) {
+                chunk.malformed = true;
+                return;
+            }
+            chunk.edges.push_back(Edge{ u, v, static_cast<EdgeWeight>(weight) });
+            chunk.maxVertex = std::max(chunk.maxVertex, std::max(u, v));
+        });
+    });
+
+    long long vertexTotal = 0;
+    size_t edgeTotal = 0;
+    for (const EdgeListChunk &chunk : chunks) {
+        if (chunk.malformed) return Status::Malformed;
+        vertexTotal = std::max(vertexTotal, static_cast<long long>(chunk.maxVertex) + 1);
+        edgeTotal += chunk.edges.size();
+    }
+    if (edgeTotal > static_cast<size_t>(INT_MAX)) return Status::Malformed;
+    if (vertexTotal > 2 * static_cast<long long>(edgeTotal) + kMaxIdGap) return Status::Malformed;
+    const int n = static_cast<int>(vertexTotal);
+
+    GraphBuilder builder;
+    builder.reserve(n, static_cast<int>(edgeTotal));
+    for (int i = 0; i < n; ++i) builder.addVertex(place(i, n));
+    for (EdgeListChunk &chunk : chunks) {
+        builder.addEdges(chunk.edges.begin(), chunk.edges.end());
+        std::vector<Edge>().swap(chunk.edges);
+    }
+    out = builder.build();
+    return Status::Ok;
+}
+
+Status readDimacs(const QString &path, const Placement &place, Graph &out) {
+    MappedFile file;
+    if (!file.open(path)) return Status::CannotOpen;
+    const std::vector<const char*> bounds = lineChunks(file.begin(), file.end());
+    const int chunkCount = static_cast<int>(bounds.size()) - 1;
+
+    std::vector<DimacsChunk> chunks(chunkCount);
+    ThreadPool::shared().parallelFor(chunkCount, [&](int c, int) {
+        DimacsChunk &chunk = chunks[c];
+        forEachLine(bounds[c], bounds[c + 1], [&](const char *at, const char *end) {
+            if (chunk.malformed) return;
+            const char *tokenEnd = nullptr;
+            if (!nextToken(at, end, tokenEnd) || *at == 'c') return;
+            const char kind = tokenEnd - at == 1 ? *at : '\0';
+            int u = 0, v = 0, n = 0, m = 0;
+            double weight = 0.0;
+            bool ok = kind == 'a' || kind == 'p';
+            if (kind == 'a') {
+                at = tokenEnd;
+                ok = nextToken(at, end, tokenEnd) && parseInt(at, tokenEnd, u) && u >= 1;
+                at = tokenEnd;
+                ok = ok && nextToken(at, end, tokenEnd) && parseInt(at, tokenEnd, v) && v >= 1;
+                at = tokenEnd;
+                ok = ok && nextToken(at, end, tokenEnd) && parseWeight(at, tokenEnd, weight);
+                if (ok) {
+                    chunk.arcs.push_back(Edge{ u - 1, v - 1, static_cast<EdgeWeight>(weight), true });
+                    chunk.maxVertex = std::max(chunk.maxVertex, std::max(u, v) - 1);
+                }
+            } else if (kind == 'p') {
+                at = tokenEnd;
+                ok = nextToken(at, end, tokenEnd); // problem name, "sp"
+                at = tokenEnd;
+                ok = ok && nextToken(at, end, tokenEnd) && parseInt(at, tokenEnd, n) && n >= 0;
+                at = tokenEnd;
+                ok = ok && nextToken(at, end, tokenEnd) && parseInt(at, tokenEnd, m) && m >= 0;
+                chunk.vertexTotal = n;
+                chunk.arcTotal = m;
+                ++chunk.problemLines;
+            }
+            if (ok) {
+                at = tokenEnd;
+                ok = !nextToken(at, end, tokenEnd);
+            }
+            if (!ok) chunk.malformed = true;
+        });
+    });
+
+    int n = -1, problemLines = 0, maxVertex = -1;
+    long long declaredArcs = 0;
+    size_t arcTotal = 0;
+    for (const DimacsChunk &chunk : chunks) {
+        if (chunk.malformed) return Status::Malformed;
+        if (chunk.problemLines) {
+            n = chunk.vertexTotal;
+            declaredArcs = chunk.arcTotal;
+        }
+        problemLines += chunk.problemLines;
+        maxVertex = std::max(maxVertex, chunk.maxVertex);
+        arcTotal += chunk.arcs.size();
+    }
+    if (problemLines != 1 || maxVertex >= n || static_cast<long long>(arcTotal) != declaredArcs) return Status::Malformed;
+
+    std::vector<Edge> arcs;
+    arcs.reserve(arcTotal);
+    for (DimacsChunk &chunk : chunks) {
+        arcs.insert(arcs.end(), chunk.arcs.begin(), chunk.arcs.end());
+        std::vector<Edge>().swap(chunk.arcs);
+    }
+
+    // Pair opposite arcs: group arcs by unordered endpoints and weight (ties
+    // in file order), then match the k-th u->v arc with the k-th v->u arc (or
+    // consecutive self-loops). The earlier arc of a pair becomes the
+    // undirected edge, so edges keep the order of their first arc.
+    std::vector<int> order(arcs.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto key = [&arcs](int a) {
+        const Edge &e = arcs[a];
+        return std::make_tuple(std::min(e.u, e.v), std::max(e.u, e.v), e.weight, a);
+    };
+    std::sort(order.begin(), order.end(), [&key](int a, int b) { return key(a) < key(b); });
+    std::vector<char> dropped(arcs.size(), 0);
+    std::vector<int> forward, backward;
+    for (size_t first = 0; first < order.size();) {
+        const Edge &head = arcs[order[first]];
+        size_t last = first;
+        forward.clear();
+        backward.clear();
+        for (; last < order.size(); ++last) {
+            const Edge &e = arcs[order[last]];
+            if (std::min(e.u, e.v) != std::min(head.u, head.v) || std::max(e.u, e.v) != std::max(head.u, head.v)
+                || e.weight != head.weight) break;
+            (e.u <= e.v ? forward : backward).push_back(order[last]);
+        }
+        if (head.u == head.v) {
+            for (size_t k = 0; k + 1 < forward.size(); k += 2) {
+                arcs[forward[k]].directed = false;
+                dropped[forward[k + 1]] = 1;
+            }
+        } else {
+            for (size_t k = 0; k < std::min(forward.size(), backward.size()); ++k) {
+                const int keep = std::min(forward[k], backward[k]);
+                arcs[keep].directed = false;
+                dropped[keep == forward[k] ? backward[k] : forward[k]] = 1;
+            }
+        }
+        first = last;
+    }
+
+    GraphBuilder builder;
+    builder.reserve(n, static_cast<int>(arcs.size()));
+    for (int i = 0; i < n; ++i) builder.addVertex(place(i, n));
+    for (size_t a = 0; a < arcs.size(); ++a) {
+        const Edge &e = arcs[a];
+        if (!dropped[a]) builder.addEdge(e.u, e.v, e.weight, e.directed);
+    }
+    out = builder.build();
+    return Status::Ok;
+}
+
+Status readMetis(const QString &path, const Placement &place, Graph &out) {
+    MappedFile file;
+    if (!file.open(path)) return Status::CannotOpen;
+
+    // The header is the first line that is neither blank nor a comment
+    int fields[4] = { -1, -1, 0, 0 };
+    bool headerOk = false;
+    const char *body = file.begin();
+    while (body < file.end()) {
+        const void *nl = std::memchr(body, '\n', static_cast<size_t>(file.end() - body));
+        const char *end = nl ? static_cast<const char*>(nl) : file.end();
+        const char *at = body;
+        const char *tokenEnd = nullptr;
+        body = nl ? end + 1 : end;
+        if (!nextToken(at, end, tokenEnd) || *at == '%') continue;
+        int count = 0;
+        for (; count < 4 && nextToken(at, end, tokenEnd); at = tokenEnd, ++count) {
+            if (!parseInt(at, tokenEnd, fields[count]) || fields[count] < 0) break;
+        }
+        headerOk = count >= 2 && !nextToken(at, end, tokenEnd);
+        break;
+    }
+    const int n = fields[0], m = fields[1], format = fields[2], constraints = fields[3];
+    headerOk = headerOk && format <= 111 && format % 10 <= 1 && format / 10 % 10 <= 1;
+    if (!headerOk) return Status::Malformed;
+    const bool hasEdgeWeights = format % 10 == 1;
+    // per line: an optional vertex size, then the vertex weights, then neighbors
+    const int skipped = (format / 100 == 1 ? 1 : 0) + (format / 10 % 10 == 1 ? std::max(constraints, 1) : 0);
+
+    const std::vector<const char*> bounds = lineChunks(body, file.end());
+    const int chunkCount = static_cast<int>(bounds.size()) - 1;
+    std::vector<MetisChunk> chunks(chunkCount);
+    ThreadPool::shared().parallelFor(chunkCount, [&](int c, int) {
+        MetisChunk &chunk = chunks[c];
+        forEachLine(bounds[c], bounds[c + 1], [&](const char *at, const char *end) {
+            if (chunk.malformed) return;
+            const char *tokenEnd = nullptr;
+            const char *lineStart = at;
+            if (nextToken(at, end, tokenEnd) && *at == '%') return;
+            at = lineStart;
+            const int row = chunk.rows++;
+            int field = 0;
+            for (; nextToken(at, end, tokenEnd); at = tokenEnd, ++field) {
+                if (field < skipped) continue;
+                int neighbor = 0;
+                if (!parseInt(at, tokenEnd, neighbor) || neighbor < 1 || neighbor > n) {
+                    chunk.malformed = true;
+                    return;
+                }
+                double weight = 1.0;
+                if (hasEdgeWeights) {
+                    at = tokenEnd;
+                    if (!nextToken(at, end, tokenEnd) || !parseWeight(at, tokenEnd, weight)) {
+                        chunk.malformed = true;
+                        return;
+                    }
+                }
+                // the global row is at least row, so a lower neighbor is
+                // already known to list this edge itself
+                if (neighbor - 1 >= row) chunk.entries.push_back(Edge{ row, neighbor - 1, static_cast<EdgeWeight>(weight) });
+            }
+            if (field > 0) chunk.lastFilledRow = row;
+        });
+    });
+
+    int rows = 0;
+    size_t entryTotal = 0;
+    for (const MetisChunk &chunk : chunks) {
+        if (chunk.malformed || (chunk.lastFilledRow >= 0 && rows + chunk.lastFilledRow >= n)) return Status::Malformed;
+        rows += chunk.rows;
+        entryTotal += chunk.entries.size();
+    }
+
+    GraphBuilder builder;
+    builder.reserve(n, static_cast<int>(std::min<size_t>(entryTotal, INT_MAX)));
+    for (int i = 0; i < n; ++i) builder.addVertex(place(i, n));
+    long long edgeTotal = 0;
+    int firstRow = 0;
+    for (MetisChunk &chunk : chunks) {
+        int loopRow = -1;
+        bool loopOpen = false; // a self-loop's first listing is waiting for its second
+        for (const Edge &entry : chunk.entries) {
+            const int u = firstRow + entry.u;
+            if (entry.v < u) continue;
+            if (entry.v == u) {
+                if (loopRow != u) {
+                    loopRow = u;
+                    loopOpen = false;
+                }
+                loopOpen = !loopOpen;
+                if (loopOpen) continue;
+            }
+            builder.addEdge(u, entry.v, entry.weight);
+            ++edgeTotal;
+        }
+        firstRow += chunk.rows;
+        std::vector<Edge>().swap(chunk.entries);
+    }
+    if (edgeTotal != m) return Status::Malformed;
+    out = builder.build();
+    return Status::Ok;
+}
+
+bool writeEdgeList(const QString &path, const Graph &g) {
+    BufferedWriter out;
+    if (!out.open(path)) return false;
+    int n = 0;
+    const std::vector<int> id = denseIds(g, n);
+    for (const Edge &e : g.liveEdges()) {
+        out.putInt(id[e.u]);
+        out.put(' ');
+        out.putInt(id[e.v]);
+        out.put(' ');
+        out.putWeight(e.weight);
+        out.put('\n');
+    }
+    return out.finish();
+}
+
+bool writeDimacs(const QString &path, const Graph &g) {
+    BufferedWriter out;
+    if (!out.open(path)) return false;
+    int n = 0;
+    const std::vector<int> id = denseIds(g, n);
+    long long arcs = 0;
+    for (const Edge &e : g.liveEdges()) arcs += e.directed ? 1 : 2;
+    out.put("p sp ");
+    out.putInt(n);
+    out.put(' ');
+    out.putInt(arcs);
+    out.put('\n');
+    auto arc = [&out](int from, int to, EdgeWeight weight) {
+        out.put("a ");
+        out.putInt(from + 1);
+        out.put(' ');
+        out.putInt(to + 1);
+        out.put(' ');
+        out.putWeight(weight);
+        out.put('\n');
+    };
+    for (const Edge &e : g.liveEdges()) {
+        arc(id[e.u], id[e.v], e.weight);
+        if (!e.directed) arc(id[e.v], id[e.u], e.weight);
+    }
+    return out.finish();
+}
+
+bool writeMetis(const QString &path, const Graph &g) {
+    BufferedWriter out;
+    if (!out.open(path)) return false;
+    int n = 0;
+    const std::vector<int> id = denseIds(g, n);
+    // fmt 1: every neighbor is followed by its edge weight
+    out.putInt(n);
+    out.put(' ');
+    out.putInt(g.edgeCount());
+    out.put(" 1\n");
+    const auto &edges = g.getEdges();
+    for (const Vertex &v : g.liveVertices()) {
+        const int u = g.idOf(v);
+        bool first = true;
+        for (int edgeId : g.incidentEdges(u)) {
+            const Edge &e = edges[edgeId];
+            if (!first) out.put(' ');
+            first = false;
+            out.putInt(id[e.u == u ? e.v : e.u] + 1);
+            out.put(' ');
+            out.putWeight(e.weight);
+        }
+        out.put('\n');
+    }
+    return out.finish();
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Graph.h"
+#include <QPointF>
+#include <QString>
+#include <functional>
+
+// Headless file import and export. A file being read is memory-mapped and
+// cut into line-aligned chunks that are scanned in parallel on the shared
+// pool with a hand-rolled number parser; each chunk collects its edges, which
+// are then handed to a GraphBuilder in file order. No dense matrix is ever
+// materialized, so a matrix costs O(file size) time and O(V+E) memory, and
+// the sparse formats load in O(E).
+namespace GraphIO {
+
+enum class Status {
+    Ok,
+    CannotOpen,
+    NotSquare, // adjacency matrix: row count and row lengths disagree
+    Malformed  // a line does not fit the format, an id is out of range, a
+               // weight is not a finite number >= 0, or the counts in a
+               // DIMACS/METIS header do not match the body
+};
+
+// Position of vertex `index` out of `count`, used to lay out imported vertices.
+using Placement = std::function<QPointF(int index, int count)>;
+
+// Square adjacency matrix, one row per non-blank line, entries separated by
+// whitespace or commas. Every nonzero integer entry above the diagonal adds
+// an undirected edge of weight 1 (the lower triangle is ignored, and entries
+// that are not integers count as 0).
+Status readAdjacencyMatrix(const QString &path, const Placement &place, Graph &out);
+
+// Edge list, one undirected edge per line as "u v [weight]" with 0-based
+// vertex ids separated by whitespace or commas; the weight defaults to 1 and
+// must be a finite number >= 0 (the solvers assume it), else the file is
+// Malformed. Blank lines and lines starting with '#' or '%' are skipped. The
+// graph gets vertices 0..max id, and repeated lines become parallel edges; an
+// id more than about a million past twice the edge count is Malformed.
+Status readEdgeList(const QString &path, const Placement &place, Graph &out);
+
+// DIMACS shortest-path format (.gr): "c" comment lines, one "p sp n m" line
+// and m lines "a u v w", one per arc, with 1-based ids. Two opposite arcs
+// with the same weight become one undirected edge and an arc left without
+// such a partner a directed one. Decimal weights are accepted as well, but
+// like everywhere here they must be finite and >= 0.
+Status readDimacs(const QString &path, const Placement &place, Graph &out);
+
+// METIS graph format: "%" comment lines, a header "n m [fmt [ncon]]", then
+// line i lists the 1-based neighbors of vertex i, each followed by the edge
+// weight (finite, >= 0) when fmt ends in 1; vertex sizes and weights are
+// skipped. An edge appears on both of its endpoints' lines and is taken from
+// the lower one, so parallel edges survive; a self-loop appears twice on its
+// own line.
+Status readMetis(const QString &path, const Placement &place, Graph &out);
+
+// Writers for the sparse formats above, streamed through a buffer in O(V+E)
+// without copying the graph. Live vertices are renumbered densely in id
+// order, and each weight is written in the shortest form that reads back to
+// the same stored value. Edge lists and METIS are undirected, so directed
+// edges lose their direction there; DIMACS writes an undirected edge as two
+// opposite arcs and a directed one as one. An edge list has no vertex count,
+// so isolated vertices numbered after the last edge endpoint do not survive a
+// round trip; DIMACS and METIS keep them. False if the file cannot be written.
+bool writeEdgeList(const QString &path, const Graph &g);
+bool writeDimacs(const QString &path, const Graph &g);
+bool writeMetis(const QString &path, const Graph &g);
+
+}
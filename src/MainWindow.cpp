@@ -1,5 +1,7 @@
 #include "MainWindow.h"
 #include "ChinesePostman.h"
+#include "ContractionHierarchy.h"
+#include "GraphIO.h"
 #include <QToolBar>
 #include <QFileDialog>
 #include <QPrinter>
@@ -9,9 +11,28 @@
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QFile>
+#include <QFileInfo>
 #include <QTextStream>
-#include <QRegularExpression>
 #include <QImageReader>
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <QtConcurrent>
+#include <algorithm>
+
+// Tổng trọng số các cạnh trên lộ trình; id >= số slot cạnh là cạnh lặp, tra cạnh gốc qua duplicateOf
+static double routeLength(const Graph &g, const std::vector<int> &edgeOrder, const std::vector<int> &duplicateOf = {}) {
+    const auto &edges = g.getEdges();
+    double total = 0.0;
+    for (int id : edgeOrder) {
+        if (id >= 0 && static_cast<size_t>(id) >= edges.size()) {
+            size_t k = static_cast<size_t>(id) - edges.size();
+            id = k < duplicateOf.size() ? duplicateOf[k] : -1;
+        }
+        if (id >= 0 && static_cast<size_t>(id) < edges.size()) total += edges[id].weight;
+    }
+    return total;
+}
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setupUi();
@@ -84,12 +105,16 @@ void MainWindow::setupUi() {
     tb->addSeparator();
     actEuler = tb->addAction("Euler", this, &MainWindow::onComputeEuler);
     actPostman = tb->addAction("Postman", this, &MainWindow::onComputePostman);
+    actShortestRoute = tb->addAction("Shortest Route", this, &MainWindow::onShortestRoute);
+    actBuildIndex = tb->addAction("Build Route Index", this, &MainWindow::onBuildRouteIndex);
+    actLoadIndex = tb->addAction("Load Route Index", this, &MainWindow::onLoadRouteIndex);
     tb->addSeparator();
     actExportImg = tb->addAction("Export Image", this, &MainWindow::onExportImage);
     actExportPdf = tb->addAction("Export PDF", this, &MainWindow::onExportPdf);
     actImportMap = tb->addAction("Import Map Background", this, &MainWindow::onImportMapBackground);
     actClearMap = tb->addAction("Clear Map Background", this, &MainWindow::onClearMapBackground);
     actExportMatrix = tb->addAction("Export Matrix", this, &MainWindow::onExportMatrix);
+    actExportGraph = tb->addAction("Export Graph", this, &MainWindow::onExportGraph);
     tb->addSeparator();
     // Blue Show Summary button next to Export PDF
     btnShowSummary = new QPushButton("Show Summary", tb);
@@ -109,7 +134,7 @@ void MainWindow::onShowSummary() {
     const auto &verts = g.getVertices();
     const auto &edges = g.getEdges();
 
-    if (verts.empty()) {
+    if (g.vertexCount() == 0) {
         QMessageBox::information(this, "Summary", "The graph is empty.");
         return;
     }
@@ -119,38 +144,29 @@ void MainWindow::onShowSummary() {
 
     // Input Graph Information with detailed description
     text += "Input Graph Information\n";
-    text += QString("The examined graph comprises %1 vertices and %2 edges, representing a segment of an urban traffic network. The edges are listed as follows:\n").arg(verts.size()).arg(edges.size());
-    for (const auto &e : edges) {
+    text += QString("The examined graph comprises %1 vertices and %2 edges, representing a segment of an urban traffic network. The edges are listed as follows:\n").arg(g.vertexCount()).arg(g.edgeCount());
+    for (const auto &e : g.liveEdges()) {
         if (e.u >= 0 && e.u < verts.size() && e.v >= 0 && e.v < verts.size())
-            text += QString("+ %1-%2: %3\n").arg(verts[e.u].name).arg(verts[e.v].name).arg(e.id + 1);
+            text += QString("+ %1-%2: %3\n").arg(g.vertexName(e.u)).arg(g.vertexName(e.v)).arg(g.idOf(e) + 1);
         else
-            text += QString("+ [invalid edge: %1-%2] %3\n").arg(e.u).arg(e.v).arg(e.id + 1);
+            text += QString("+ [invalid edge: %1-%2] %3\n").arg(e.u).arg(e.v).arg(g.idOf(e) + 1);
     }
 
     // Vertex Degrees
     text += "\nVertex Degrees\n";
-    QVector<int> deg(verts.size(), 0);
-    for (const auto &e : edges) { 
-        if (e.u >= 0 && static_cast<size_t>(e.u) < deg.size()) deg[e.u]++; 
-        if (e.v >= 0 && static_cast<size_t>(e.v) < deg.size()) deg[e.v]++; 
-    }
-    for (size_t i = 0; i < deg.size(); ++i) {
-        text += QString("+ %1 = %2\n").arg(verts[i].name).arg(deg[i]);
+    for (const auto &v : g.liveVertices()) {
+        const int id = g.idOf(v);
+        text += QString("+ %1 = %2\n").arg(g.vertexName(id)).arg(g.degree(id));
     }
 
     // Eulerian Circuit Analysis
     text += "\nEulerian Circuit Analysis\n";
-    size_t oddCount = 0;
-    std::vector<int> odd;
-    odd.reserve(deg.size());
-    for (size_t i = 0; i < deg.size(); ++i) {
-        if (deg[i] % 2 == 1) {
-            ++oddCount;
-            odd.push_back(static_cast<int>(i));
-        }
-    }
+    // Graph keeps the odd-degree set current; sort it only for display
+    std::vector<int> odd = g.oddVertices();
+    std::sort(odd.begin(), odd.end());
+    size_t oddCount = odd.size();
 
-    if (edges.empty()) {
+    if (g.edgeCount() == 0) {
         text += "The graph is empty (trivially Eulerian).\n";
     } else if (oddCount == 0) {
         text += "The graph possesses an Eulerian circuit, as all vertices have even degrees.\n";
@@ -158,7 +174,7 @@ void MainWindow::onShowSummary() {
         text += "The graph possesses an Eulerian path, with exactly two vertices of odd degree.\n";
         text += "Odd degree vertices: ";
         for (size_t i = 0; i < odd.size(); ++i) {
-            text += verts[odd[i]].name;
+            text += g.vertexName(odd[i]);
             if (i + 1 < odd.size()) text += ", ";
         }
         text += "\n";
@@ -168,7 +184,7 @@ void MainWindow::onShowSummary() {
         text += "The presence of multiple odd-degree vertices precludes both an Eulerian circuit and an Eulerian trail in the current graph configuration.\n\n";
         text += "Odd degree vertices: ";
         for (size_t i = 0; i < odd.size(); ++i) {
-            text += verts[odd[i]].name;
+            text += g.vertexName(odd[i]);
             if (i + 1 < odd.size()) text += ", ";
         }
         text += "\n";
@@ -185,19 +201,20 @@ void MainWindow::onShowSummary() {
         const Edge &e0 = edges[eulerRes->edgeOrder[0]];
         int startVertex = (e0.u >= 0 && e0.u < verts.size()) ? e0.u : 0;
         curr = startVertex;
-        vseq << verts[curr].name;
+        vseq << g.vertexName(curr);
         for (int eid : eulerRes->edgeOrder) {
             if (eid < 0 || eid >= edges.size()) continue;
             const Edge &E = edges[eid];
             int next = (E.u == curr) ? E.v : E.u;
             if (next < 0 || next >= verts.size()) break;
-            vseq << verts[next].name;
+            vseq << g.vertexName(next);
             curr = next;
             eids << QString::number(eid + 1);
         }
         text += eulerRes->isCycle ? "Eulerian cycle found:\n" : "Eulerian path found:\n";
         text += "Vertex order: " + vseq.join(" -> ") + "\n";
         text += "Edge traversal: " + eids.join(", ") + "\n";
+        text += QString("Route length: %1\n").arg(routeLength(g, eulerRes->edgeOrder));
     } else {
         text += "\nChinese Postman (approx):\n";
         auto post = ChinesePostmanOptimal::solve(g);
@@ -205,33 +222,43 @@ void MainWindow::onShowSummary() {
             QStringList eids;
             QStringList vseq;
             int curr = -1;
-            // Tìm startVertex an toàn
-            int firstEid = post.edgeOrder[0];
             const auto& edges = g.getEdges();
             const auto& verts = g.getVertices();
+            // Cạnh lặp có id >= edges.size(): tra cạnh gốc qua duplicateOf rồi đi tiếp theo cạnh đó
+            auto edgeAt = [&](int eid) -> const Edge* {
+                if (eid >= 0 && static_cast<size_t>(eid) >= edges.size()) {
+                    size_t k = static_cast<size_t>(eid) - edges.size();
+                    eid = k < post.duplicateOf.size() ? post.duplicateOf[k] : -1;
+                }
+                return eid >= 0 && static_cast<size_t>(eid) < edges.size() ? &edges[eid] : nullptr;
+            };
+            // Tìm startVertex an toàn: đầu mút của cạnh đầu tiên không nằm trên cạnh thứ hai
             int startVertex = 0;
-            if (firstEid >= 0 && static_cast<size_t>(firstEid) < edges.size()) {
-                const Edge &e0 = edges[firstEid];
-                startVertex = (e0.u >= 0 && static_cast<size_t>(e0.u) < verts.size()) ? e0.u : 0;
+            if (const Edge *e0 = edgeAt(post.edgeOrder[0])) {
+                startVertex = e0->u;
+                const Edge *e1 = post.edgeOrder.size() > 1 ? edgeAt(post.edgeOrder[1]) : nullptr;
+                if (e1 && (e0->u == e1->u || e0->u == e1->v) && e0->v != e1->u && e0->v != e1->v) startVertex = e0->v;
+                if (startVertex < 0 || static_cast<size_t>(startVertex) >= verts.size()) startVertex = 0;
             }
             curr = startVertex;
-            vseq << verts[curr].name;
+            vseq << g.vertexName(curr);
             for (int eid : post.edgeOrder) {
-                if (eid < 0) continue;
-                if (eid < edges.size()) {
-                    const Edge &E = edges[eid];
-                    int next = (E.u == curr) ? E.v : E.u;
-                    if (next < 0 || static_cast<size_t>(next) >= verts.size()) break;
-                    vseq << verts[next].name;
-                    curr = next;
-                    eids << QString::number(eid + 1);
-                } else {
-                    // duplicate edge
-                    eids << QString("%1 (duplicate edge)").arg(eid + 1);
-                }
+                const Edge *E = edgeAt(eid);
+                if (!E) continue;
+                int next = (E->u == curr) ? E->v : E->u;
+                if (next < 0 || static_cast<size_t>(next) >= verts.size()) break;
+                vseq << g.vertexName(next);
+                curr = next;
+                if (static_cast<size_t>(eid) < edges.size()) eids << QString::number(eid + 1);
+                else eids << QString("%1 (duplicate edge)").arg(g.idOf(*E) + 1);
             }
             text += vseq.join(" -> ") + "\n";
             text += "Edge order: " + eids.join(", ") + "\n";
+            double streetsTotal = 0.0;
+            for (const auto &e : g.liveEdges()) streetsTotal += e.weight;
+            text += QString("Route length: %1 (streets total %2)\n")
+                        .arg(routeLength(g, post.edgeOrder, post.duplicateOf))
+                        .arg(streetsTotal);
         } else {
             text += "No valid route found.\n";
         }
@@ -281,6 +308,71 @@ void MainWindow::onComputePostman() {
     statusBar()->showMessage("Postman route (optimal) computed", 3000);
 }
 
+void MainWindow::onShortestRoute() {
+    canvas->setMode(GraphCanvas::ShortestRoute);
+    statusBar()->showMessage("Select start vertex", 3000);
+}
+
+void MainWindow::onBuildRouteIndex() {
+    const Graph &g = canvas->model();
+    if (g.vertexCount() == 0) {
+        QMessageBox::information(this, "Route Index", "Đồ thị trống.");
+        return;
+    }
+    using Index = std::shared_ptr<const ContractionHierarchy>;
+    // Dựng trên luồng nền từ một bản sao đồ thị để giao diện không bị treo; người dùng có thể hủy
+    auto *progress = new QProgressDialog("Building route index...", "Cancel", 0, static_cast<int>(g.getVertices().size()), this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setAutoReset(false);
+    auto *watcher = new QFutureWatcher<Index>(this);
+    connect(watcher, &QFutureWatcher<Index>::progressValueChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcher<Index>::cancel);
+    connect(watcher, &QFutureWatcher<Index>::finished, this, [this, watcher, progress] {
+        progress->deleteLater();
+        watcher->deleteLater();
+        actBuildIndex->setEnabled(true);
+        if (watcher->isCanceled() || watcher->future().resultCount() == 0) {
+            statusBar()->showMessage("Route index build cancelled", 3000);
+            return;
+        }
+        Index index = watcher->result();
+        // attach từ chối chỉ mục nếu đồ thị đã bị sửa trong lúc dựng
+        if (!canvas->model().attachContractionHierarchy(index)) {
+            QMessageBox::warning(this, "Route Index", "Đồ thị đã thay đổi trong lúc dựng chỉ mục, hãy dựng lại.");
+            return;
+        }
+        // Lưu chỉ mục cạnh file đồ thị để lần sau nạp lại, không phải dựng lại
+        QString file = QFileDialog::getSaveFileName(this, "Save route index", {}, "Route index (*.chx)");
+        if (!file.isEmpty() && !index->save(file.toStdString())) {
+            QMessageBox::warning(this, "Route Index", "Không thể ghi file.");
+            return;
+        }
+        statusBar()->showMessage(QString("Route index built (%1 shortcuts)").arg(index->shortcutCount()), 3000);
+    });
+    actBuildIndex->setEnabled(false);
+    watcher->setFuture(QtConcurrent::run([graph = g](QPromise<Index> &promise) {
+        promise.setProgressRange(0, static_cast<int>(graph.getVertices().size()));
+        Index index = ContractionHierarchy::build(graph, [&promise](int done, int) {
+            promise.setProgressValue(done);
+            return !promise.isCanceled();
+        });
+        if (index) promise.addResult(index);
+    }));
+}
+
+void MainWindow::onLoadRouteIndex() {
+    QString file = QFileDialog::getOpenFileName(this, "Open route index", {}, "Route index (*.chx);;All files (*.*)");
+    if (file.isEmpty()) return;
+    Graph &g = canvas->model();
+    auto index = std::make_shared<ContractionHierarchy>();
+    if (!index->load(file.toStdString(), g)) {
+        QMessageBox::warning(this, "Route Index", "File không hợp lệ hoặc được dựng cho đồ thị khác.");
+        return;
+    }
+    g.attachContractionHierarchy(index);
+    statusBar()->showMessage("Route index loaded", 3000);
+}
+
 void MainWindow::onExportImage() {
     QString file = QFileDialog::getSaveFileName(this, "Export Image", {}, "PNG Image (*.png)");
     if (file.isEmpty()) return;
@@ -305,52 +397,42 @@ void MainWindow::onExportPdf() {
 }
 
 void MainWindow::onAttachFiles() {
-    // Chọn file txt chứa ma trận kề vuông, phần tử cách nhau bởi khoảng trắng hoặc dấu phẩy
-    QString file = QFileDialog::getOpenFileName(this, "Open adjacency matrix", {}, "Text files (*.txt);;All files (*.*)");
+    // Chọn file txt chứa ma trận kề vuông, phần tử cách nhau bởi khoảng trắng hoặc dấu phẩy,
+    // hoặc đồ thị thưa: danh sách cạnh "u v [trọng số]" (*.el, *.edges), DIMACS (*.gr), METIS (*.graph)
+    QString file = QFileDialog::getOpenFileName(this, "Open graph", {},
+        "Adjacency matrix (*.txt);;Edge list (*.el *.edges);;DIMACS (*.gr);;METIS (*.graph *.metis);;All files (*.*)");
     if (file.isEmpty()) return;
 
-    QFile f(file);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "Attach files", "Không thể mở file.");
-        return;
-    }
-
-    QVector<QVector<int>> mat;
-    QTextStream in(&f);
-    while (!in.atEnd()) {
-        QString line = in.readLine().trimmed();
-        if (line.isEmpty()) continue;
-        // thay dấu phẩy bằng khoảng trắng
-        line.replace(',', ' ');
-        QStringList parts = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-        QVector<int> row;
-        for (const QString &p : parts) row.push_back(p.toInt());
-        if (!row.isEmpty()) mat.push_back(row);
-    }
-    if (mat.isEmpty() || mat.size() != mat[0].size()) {
-        QMessageBox::warning(this, "Attach files", "Ma trận phải là ma trận vuông.");
-        return;
-    }
-
-    // Dựng đồ thị mới từ ma trận
-    Graph &g = canvas->model();
-    g.clear();
-
-    int n = mat.size();
     // Đặt đỉnh theo vòng tròn để dễ nhìn
     QSize sz = canvas->size();
     QPointF center(sz.width() / 2.0, sz.height() / 2.0);
     double radius = qMin(sz.width(), sz.height()) * 0.35;
-    for (int i = 0; i < n; ++i) {
+    auto place = [center, radius](int i, int n) {
         double ang = (2 * M_PI * i) / n - M_PI / 2; // bắt đầu từ trên cùng
-        QPointF pos(center.x() + radius * cos(ang), center.y() + radius * sin(ang));
-        g.addVertex(pos);
+        return QPointF(center.x() + radius * cos(ang), center.y() + radius * sin(ang));
+    };
+
+    // Đọc file ánh xạ bộ nhớ, song song theo từng khối dòng, không dựng ma trận n×n
+    const QString suffix = QFileInfo(file).suffix().toLower();
+    Graph g;
+    GraphIO::Status st;
+    if (suffix == "el" || suffix == "edges") st = GraphIO::readEdgeList(file, place, g);
+    else if (suffix == "gr") st = GraphIO::readDimacs(file, place, g);
+    else if (suffix == "graph" || suffix == "metis") st = GraphIO::readMetis(file, place, g);
+    else st = GraphIO::readAdjacencyMatrix(file, place, g);
+    if (st == GraphIO::Status::CannotOpen) {
+        QMessageBox::warning(this, "Attach files", "Không thể mở file.");
+        return;
     }
-    for (int i = 0; i < n; ++i) {
-        for (int j = i + 1; j < n; ++j) {
-            if (mat[i][j] != 0) g.addEdge(i, j);
-        }
+    if (st == GraphIO::Status::NotSquare) {
+        QMessageBox::warning(this, "Attach files", "Ma trận phải là ma trận vuông.");
+        return;
     }
+    if (st == GraphIO::Status::Malformed) {
+        QMessageBox::warning(this, "Attach files", "File sai định dạng hoặc số đỉnh/cạnh không khớp với phần đầu file.");
+        return;
+    }
+    canvas->model() = std::move(g);
 
     canvas->clearRoute();
     canvas->update();
@@ -377,7 +459,9 @@ void MainWindow::onClearMapBackground() {
 }
 
 void MainWindow::onExportMatrix() {
-    const Graph &g = canvas->model();
+    // Ma trận cần chỉ số liền nhau: xuất từ bản sao đã dọn các đỉnh/cạnh bị xóa
+    Graph g = canvas->model();
+    g.compact();
     const auto &verts = g.getVertices();
     const auto &edges = g.getEdges();
     int n = static_cast<int>(verts.size());
@@ -411,6 +495,46 @@ void MainWindow::onExportMatrix() {
     statusBar()->showMessage("Đã xuất ma trận kề", 3000);
 }
 
+void MainWindow::onExportGraph() {
+    // Định dạng thưa O(E): giữ trọng số và các cạnh song song, không cần ma trận n×n
+    const Graph &g = canvas->model();
+    if (g.vertexCount() == 0) {
+        QMessageBox::information(this, "Export Graph", "Đồ thị trống.");
+        return;
+    }
+    QString filter;
+    QString file = QFileDialog::getSaveFileName(this, "Save graph", {},
+        "DIMACS (*.gr);;METIS (*.graph);;Edge list (*.el)", &filter);
+    if (file.isEmpty()) return;
+    // Lấy định dạng theo đuôi file, nếu không có thì theo bộ lọc đã chọn
+    QString suffix = QFileInfo(file).suffix().toLower();
+    if (suffix != "el" && suffix != "gr" && suffix != "graph") {
+        suffix = filter.startsWith("Edge") ? "el" : filter.startsWith("METIS") ? "graph" : "gr";
+        file += "." + suffix;
+    }
+    if (suffix == "el") {
+        // Danh sách cạnh không ghi số đỉnh: các đỉnh cô lập sau đầu mút cạnh cuối cùng sẽ mất khi đọc lại
+        int dense = 0, kept = 0;
+        for (const auto &v : g.liveVertices()) {
+            ++dense;
+            if (g.degree(g.idOf(v)) > 0) kept = dense;
+        }
+        if (dense > kept &&
+            QMessageBox::question(this, "Export Graph",
+                QString("%1 isolated vertices will be lost: an edge list only records vertices up to the last edge endpoint. "
+                        "Save as DIMACS or METIS to keep them.\n\nExport as an edge list anyway?").arg(dense - kept)) != QMessageBox::Yes)
+            return;
+    }
+    bool ok = suffix == "gr" ? GraphIO::writeDimacs(file, g)
+            : suffix == "graph" ? GraphIO::writeMetis(file, g)
+            : GraphIO::writeEdgeList(file, g);
+    if (!ok) {
+        QMessageBox::warning(this, "Export Graph", "Không thể ghi file.");
+        return;
+    }
+    statusBar()->showMessage("Đã xuất đồ thị", 3000);
+}
+
 
 
 
@@ -23,12 +23,16 @@ private slots:
     void onClear();
     void onComputeEuler();
     void onComputePostman();
+    void onShortestRoute();
+    void onBuildRouteIndex();
+    void onLoadRouteIndex();
     void onExportImage();
     void onExportPdf();
     void onAttachFiles();
     void onImportMapBackground();
     void onClearMapBackground();
     void onExportMatrix();
+    void onExportGraph();
     void onShowSummary();
 
 private:
@@ -41,12 +45,16 @@ private:
     QAction *actClear{nullptr};
     QAction *actEuler{nullptr};
     QAction *actPostman{nullptr};
+    QAction *actShortestRoute{nullptr};
+    QAction *actBuildIndex{nullptr};
+    QAction *actLoadIndex{nullptr};
     QAction *actExportImg{nullptr};
     QAction *actExportPdf{nullptr};
     QAction *actAttach{nullptr};
     QAction *actImportMap{nullptr};
     QAction *actClearMap{nullptr};
     QAction *actExportMatrix{nullptr};
+    QAction *actExportGraph{nullptr};
     QPushButton *btnShowSummary{nullptr};
 
     void setupUi();
@@ -0,0 +1,483 @@
+#include "Matching.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+// Maximum-weight, maximum-cardinality matching on a general graph using the
+// primal-dual blossom method (Edmonds, Gabow/Galil formulation).
+// Vertices are 0..n-1 and blossoms n..2n-1. Edge k has endpoints 2k and 2k+1;
+// endpoint[p] is the vertex at end p and p^1 is the opposite end.
+class BlossomMatcher {
+public:
+    struct WeightedEdge { int i, j; double w; };
+
+    BlossomMatcher(int n, vector<WeightedEdge> edgeList);
+    vector<int> solve();
+
+private:
+    int n;
+    vector<WeightedEdge> edges;
+    vector<int> endpoint;
+    struct Arc { int p; int to; double w; };
+    vector<vector<Arc>> neighbArcs;   // per vertex: remote endpoint, remote vertex and weight
+
+    vector<int> mate;                 // vertex -> remote endpoint of matched edge, or -1
+    vector<int> label;                // 0 free, 1 S, 2 T (top-level blossoms and vertices)
+    vector<int> labelEnd;             // endpoint through which the label was assigned
+    vector<int> inBlossom;            // vertex -> top-level blossom
+    vector<int> blossomParent;
+    vector<vector<int>> blossomChilds;
+    vector<vector<int>> blossomEndps;
+    vector<int> blossomBase;
+    vector<int> bestEdge;
+    vector<vector<int>> blossomBestEdges;
+    vector<char> hasBlossomBestEdges;
+    vector<int> unusedBlossoms;
+    vector<double> dualVar;
+    vector<char> allowEdge;
+    vector<int> queue;
+
+    double slack(int k) const { return dualVar[edges[k].i] + dualVar[edges[k].j] - 2 * edges[k].w; }
+    static int wrap(int j, int size) { return ((j % size) + size) % size; }
+
+    void blossomLeaves(int b, vector<int>& out) const;
+    void assignLabel(int w, int t, int p);
+    int scanBlossom(int v, int w);
+    void addBlossom(int base, int k);
+    void expandBlossom(int b, bool endStage);
+    void augmentBlossom(int b, int v);
+    void augmentMatching(int k);
+};
+
+BlossomMatcher::BlossomMatcher(int vertexCount, vector<WeightedEdge> edgeList)
+    : n(vertexCount), edges(move(edgeList)) {
+    const int m = static_cast<int>(edges.size());
+    double maxWeight = 0.0;
+    for (const auto& e : edges) maxWeight = max(maxWeight, e.w);
+
+    endpoint.resize(2 * m);
+    neighbArcs.assign(n, {});
+    for (int k = 0; k < m; ++k) {
+        endpoint[2 * k] = edges[k].i;
+        endpoint[2 * k + 1] = edges[k].j;
+        neighbArcs[edges[k].i].push_back({2 * k + 1, edges[k].j, edges[k].w});
+        neighbArcs[edges[k].j].push_back({2 * k, edges[k].i, edges[k].w});
+    }
+
+    mate.assign(n, -1);
+    label.assign(2 * n, 0);
+    labelEnd.assign(2 * n, -1);
+    inBlossom.resize(n);
+    for (int v = 0; v < n; ++v) inBlossom[v] = v;
+    blossomParent.assign(2 * n, -1);
+    blossomChilds.assign(2 * n, {});
+    blossomEndps.assign(2 * n, {});
+    blossomBase.assign(2 * n, -1);
+    for (int v = 0; v < n; ++v) blossomBase[v] = v;
+    bestEdge.assign(2 * n, -1);
+    blossomBestEdges.assign(2 * n, {});
+    hasBlossomBestEdges.assign(2 * n, 0);
+    for (int b = 2 * n - 1; b >= n; --b) unusedBlossoms.push_back(b);
+    allowEdge.assign(m, 0);
+
+    // Jump start: the best incident weight is a feasible vertex dual, and edges
+    // tight at both ends can be matched greedily before the first stage. Only
+    // perfect matchings are sought, so free vertices need not share one dual.
+    dualVar.assign(2 * n, 0.0);
+    for (int v = 0; v < n; ++v) {
+        dualVar[v] = neighbArcs[v].empty() ? maxWeight : neighbArcs[v][0].w;
+        for (const Arc& a : neighbArcs[v]) dualVar[v] = max(dualVar[v], a.w);
+    }
+    for (int v = 0; v < n; ++v) {
+        if (mate[v] != -1) continue;
+        for (const Arc& a : neighbArcs[v]) {
+            if (mate[a.to] == -1 && dualVar[v] + dualVar[a.to] - 2 * a.w <= 0.0) {
+                mate[v] = a.p;
+                mate[a.to] = a.p ^ 1;
+                break;
+            }
+        }
+    }
+}
+
+void BlossomMatcher::blossomLeaves(int b, vector<int>& out) const {
+    if (b < n) { out.push_back(b); return; }
+    vector<int> stack{b};
+    while (!stack.empty()) {
+        int t = stack.back(); stack.pop_back();
+        if (t < n) { out.push_back(t); continue; }
+        for (int c : blossomChilds[t]) stack.push_back(c);
+    }
+}
+
+// Label the top-level blossom containing w with t via endpoint p; T-blossoms
+// immediately pass an S label on to their matched partner.
+void BlossomMatcher::assignLabel(int w, int t, int p) {
+    while (true) {
+        int b = inBlossom[w];
+        label[w] = label[b] = t;
+        labelEnd[w] = labelEnd[b] = p;
+        bestEdge[w] = bestEdge[b] = -1;
+        if (t == 1) {
+            blossomLeaves(b, queue);
+            return;
+        }
+        int base = blossomBase[b];
+        w = endpoint[mate[base]];
+        t = 1;
+        p = mate[base] ^ 1;
+    }
+}
+
+// Trace back from v and w to find a new blossom base, or -1 for an augmenting path.
+int BlossomMatcher::scanBlossom(int v, int w) {
+    vector<int> path;
+    int base = -1;
+    while (v != -1 || w != -1) {
+        int b = inBlossom[v];
+        if (label[b] & 4) { base = blossomBase[b]; break; }
+        path.push_back(b);
+        label[b] = 5;
+        if (labelEnd[b] == -1) {
+            v = -1;
+        } else {
+            v = endpoint[labelEnd[b]];
+            b = inBlossom[v];
+            v = endpoint[labelEnd[b]];
+        }
+        if (w != -1) swap(v, w);
+    }
+    for (int b : path) label[b] = 1;
+    return base;
+}
+
+void BlossomMatcher::addBlossom(int base, int k) {
+    int v = edges[k].i, w = edges[k].j;
+    int bb = inBlossom[base], bv = inBlossom[v], bw = inBlossom[w];
+    int b = unusedBlossoms.back(); unusedBlossoms.pop_back();
+    blossomBase[b] = base;
+    blossomParent[b] = -1;
+    blossomParent[bb] = b;
+    vector<int>& path = blossomChilds[b];
+    vector<int>& endps = blossomEndps[b];
+    path.clear(); endps.clear();
+    while (bv != bb) {
+        blossomParent[bv] = b;
+        path.push_back(bv);
+        endps.push_back(labelEnd[bv]);
+        v = endpoint[labelEnd[bv]];
+        bv = inBlossom[v];
+    }
+    path.push_back(bb);
+    reverse(path.begin(), path.end());
+    reverse(endps.begin(), endps.end());
+    endps.push_back(2 * k);
+    while (bw != bb) {
+        blossomParent[bw] = b;
+        path.push_back(bw);
+        endps.push_back(labelEnd[bw] ^ 1);
+        w = endpoint[labelEnd[bw]];
+        bw = inBlossom[w];
+    }
+    label[b] = 1;
+    labelEnd[b] = labelEnd[bb];
+    dualVar[b] = 0.0;
+
+    vector<int> leaves;
+    blossomLeaves(b, leaves);
+    for (int x : leaves) {
+        if (label[inBlossom[x]] == 2) queue.push_back(x);
+        inBlossom[x] = b;
+    }
+
+    // Keep, per neighbouring S-blossom, the least-slack edge out of the new blossom
+    vector<int> bestEdgeTo(2 * n, -1);
+    auto consider = [&](int e) {
+        int i = edges[e].i, j = edges[e].j;
+        if (inBlossom[j] == b) swap(i, j);
+        int bj = inBlossom[j];
+        if (bj != b && label[bj] == 1 &&
+            (bestEdgeTo[bj] == -1 || slack(e) < slack(bestEdgeTo[bj])))
+            bestEdgeTo[bj] = e;
+    };
+    for (int child : path) {
+        if (!hasBlossomBestEdges[child]) {
+            vector<int> childLeaves;
+            blossomLeaves(child, childLeaves);
+            for (int x : childLeaves)
+                for (const Arc& a : neighbArcs[x]) consider(a.p / 2);
+        } else {
+            for (int e : blossomBestEdges[child]) consider(e);
+        }
+        blossomBestEdges[child].clear();
+        hasBlossomBestEdges[child] = 0;
+        bestEdge[child] = -1;
+    }
+    blossomBestEdges[b].clear();
+    for (int e : bestEdgeTo) if (e != -1) blossomBestEdges[b].push_back(e);
+    hasBlossomBestEdges[b] = 1;
+    bestEdge[b] = -1;
+    for (int e : blossomBestEdges[b])
+        if (bestEdge[b] == -1 || slack(e) < slack(bestEdge[b])) bestEdge[b] = e;
+}
+
+void BlossomMatcher::expandBlossom(int b, bool endStage) {
+    for (int s : blossomChilds[b]) {
+        blossomParent[s] = -1;
+        if (s < n) {
+            inBlossom[s] = s;
+        } else if (endStage && dualVar[s] == 0.0) {
+            expandBlossom(s, endStage);
+        } else {
+            vector<int> leaves;
+            blossomLeaves(s, leaves);
+            for (int x : leaves) inBlossom[x] = s;
+        }
+    }
+
+    if (!endStage && label[b] == 2) {
+        // Relabel the sub-blossoms on the even-length path from the entry child to the base
+        const vector<int>& childs = blossomChilds[b];
+        const vector<int>& endps = blossomEndps[b];
+        const int len = static_cast<int>(childs.size());
+        int entryChild = inBlossom[endpoint[labelEnd[b] ^ 1]];
+        int j = static_cast<int>(find(childs.begin(), childs.end(), entryChild) - childs.begin());
+        int jstep, endpTrick;
+        if (j & 1) { j -= len; jstep = 1; endpTrick = 0; }
+        else { jstep = -1; endpTrick = 1; }
+        int p = labelEnd[b];
+        while (j != 0) {
+            label[endpoint[p ^ 1]] = 0;
+            label[endpoint[endps[wrap(j - endpTrick, len)] ^ endpTrick ^ 1]] = 0;
+            assignLabel(endpoint[p ^ 1], 2, p);
+            allowEdge[endps[wrap(j - endpTrick, len)] / 2] = 1;
+            j += jstep;
+            p = endps[wrap(j - endpTrick, len)] ^ endpTrick;
+            allowEdge[p / 2] = 1;
+            j += jstep;
+        }
+        // The base sub-blossom becomes T without passing the label to its mate
+        int bv = childs[wrap(j, len)];
+        label[endpoint[p ^ 1]] = label[bv] = 2;
+        labelEnd[endpoint[p ^ 1]] = labelEnd[bv] = p;
+        bestEdge[bv] = -1;
+        j += jstep;
+        while (childs[wrap(j, len)] != entryChild) {
+            bv = childs[wrap(j, len)];
+            if (label[bv] == 1) { j += jstep; continue; }
+            vector<int> leaves;
+            blossomLeaves(bv, leaves);
+            int reached = -1;
+            for (int x : leaves) if (label[x] != 0) { reached = x; break; }
+            if (reached != -1) {
+                label[reached] = 0;
+                label[endpoint[mate[blossomBase[bv]]]] = 0;
+                assignLabel(reached, 2, labelEnd[reached]);
+            }
+            j += jstep;
+        }
+    }
+
+    label[b] = labelEnd[b] = -1;
+    blossomChilds[b].clear();
+    blossomEndps[b].clear();
+    blossomBase[b] = -1;
+    blossomBestEdges[b].clear();
+    hasBlossomBestEdges[b] = 0;
+    bestEdge[b] = -1;
+    unusedBlossoms.push_back(b);
+}
+
+// Swap matched/unmatched edges inside blossom b so that vertex v becomes its base.
+void BlossomMatcher::augmentBlossom(int b, int v) {
+    int t = v;
+    while (blossomParent[t] != b) t = blossomParent[t];
+    if (t >= n) augmentBlossom(t, v);
+
+    vector<int>& childs = blossomChilds[b];
+    vector<int>& endps = blossomEndps[b];
+    const int len = static_cast<int>(childs.size());
+    int i = static_cast<int>(find(childs.begin(), childs.end(), t) - childs.begin());
+    int j = i;
+    int jstep, endpTrick;
+    if (i & 1) { j -= len; jstep = 1; endpTrick = 0; }
+    else { jstep = -1; endpTrick = 1; }
+    while (j != 0) {
+        j += jstep;
+        t = childs[wrap(j, len)];
+        int p = endps[wrap(j - endpTrick, len)] ^ endpTrick;
+        if (t >= n) augmentBlossom(t, endpoint[p]);
+        j += jstep;
+        t = childs[wrap(j, len)];
+        if (t >= n) augmentBlossom(t, endpoint[p ^ 1]);
+        mate[endpoint[p]] = p ^ 1;
+        mate[endpoint[p ^ 1]] = p;
+    }
+    rotate(childs.begin(), childs.begin() + i, childs.end());
+    rotate(endps.begin(), endps.begin() + i, endps.end());
+    blossomBase[b] = blossomBase[childs[0]];
+}
+
+void BlossomMatcher::augmentMatching(int k) {
+    const int starts[2][2] = { { edges[k].i, 2 * k + 1 }, { edges[k].j, 2 * k } };
+    for (const auto& start : starts) {
+        int s = start[0], p = start[1];
+        while (true) {
+            int bs = inBlossom[s];
+            if (bs >= n) augmentBlossom(bs, s);
+            mate[s] = p;
+            if (labelEnd[bs] == -1) break;
+            int t = endpoint[labelEnd[bs]];
+            int bt = inBlossom[t];
+            s = endpoint[labelEnd[bt]];
+            int j = endpoint[labelEnd[bt] ^ 1];
+            if (bt >= n) augmentBlossom(bt, j);
+            mate[j] = labelEnd[bt];
+            p = labelEnd[bt] ^ 1;
+        }
+    }
+}
+
+vector<int> BlossomMatcher::solve() {
+    for (int stage = 0; stage < n; ++stage) {
+        fill(label.begin(), label.end(), 0);
+        fill(bestEdge.begin(), bestEdge.end(), -1);
+        for (int b = n; b < 2 * n; ++b) { blossomBestEdges[b].clear(); hasBlossomBestEdges[b] = 0; }
+        fill(allowEdge.begin(), allowEdge.end(), 0);
+        queue.clear();
+
+        for (int v = 0; v < n; ++v)
+            if (mate[v] == -1 && label[inBlossom[v]] == 0) assignLabel(v, 1, -1);
+
+        bool augmented = false;
+        while (true) {
+            while (!queue.empty() && !augmented) {
+                int v = queue.back(); queue.pop_back();
+                for (const Arc& a : neighbArcs[v]) {
+                    int p = a.p;
+                    int k = p / 2;
+                    int w = a.to;
+                    if (inBlossom[v] == inBlossom[w]) continue;
+                    double kslack = 0.0;
+                    if (!allowEdge[k]) {
+                        kslack = dualVar[v] + dualVar[w] - 2 * a.w;
+                        if (kslack <= 0.0) allowEdge[k] = 1;
+                    }
+                    if (allowEdge[k]) {
+                        if (label[inBlossom[w]] == 0) {
+                            assignLabel(w, 2, p ^ 1);
+                        } else if (label[inBlossom[w]] == 1) {
+                            int base = scanBlossom(v, w);
+                            if (base >= 0) {
+                                addBlossom(base, k);
+                            } else {
+                                augmentMatching(k);
+                                augmented = true;
+                                break;
+                            }
+                        } else if (label[w] == 0) {
+                            label[w] = 2;
+                            labelEnd[w] = p ^ 1;
+                        }
+                    } else if (label[inBlossom[w]] == 1) {
+                        int b = inBlossom[v];
+                        if (bestEdge[b] == -1 || kslack < slack(bestEdge[b])) bestEdge[b] = k;
+                    } else if (label[w] == 0) {
+                        if (bestEdge[w] == -1 || kslack < slack(bestEdge[w])) bestEdge[w] = k;
+                    }
+                }
+            }
+            if (augmented) break;
+
+            // Pick the smallest dual adjustment that makes progress
+            int deltaType = -1, deltaEdge = -1, deltaBlossom = -1;
+            double delta = 0.0;
+            for (int v = 0; v < n; ++v) {
+                if (label[inBlossom[v]] == 0 && bestEdge[v] != -1) {
+                    double d = slack(bestEdge[v]);
+                    if (deltaType == -1 || d < delta) { delta = d; deltaType = 2; deltaEdge = bestEdge[v]; }
+                }
+            }
+            for (int b = 0; b < 2 * n; ++b) {
+                if (blossomParent[b] == -1 && label[b] == 1 && bestEdge[b] != -1) {
+                    double d = slack(bestEdge[b]) / 2.0;
+                    if (deltaType == -1 || d < delta) { delta = d; deltaType = 3; deltaEdge = bestEdge[b]; }
+                }
+            }
+            for (int b = n; b < 2 * n; ++b) {
+                if (blossomBase[b] >= 0 && blossomParent[b] == -1 && label[b] == 2 &&
+                    (deltaType == -1 || dualVar[b] < delta)) {
+                    delta = dualVar[b]; deltaType = 4; deltaBlossom = b;
+                }
+            }
+            if (deltaType == -1) {
+                // No further augmenting path: maximum cardinality reached
+                deltaType = 1;
+                delta = max(0.0, *min_element(dualVar.begin(), dualVar.begin() + n));
+            }
+
+            for (int v = 0; v < n; ++v) {
+                if (label[inBlossom[v]] == 1) dualVar[v] -= delta;
+                else if (label[inBlossom[v]] == 2) dualVar[v] += delta;
+            }
+            for (int b = n; b < 2 * n; ++b) {
+                if (blossomBase[b] >= 0 && blossomParent[b] == -1) {
+                    if (label[b] == 1) dualVar[b] += delta;
+                    else if (label[b] == 2) dualVar[b] -= delta;
+                }
+            }
+
+            if (deltaType == 1) {
+                break;
+            } else if (deltaType == 2) {
+                allowEdge[deltaEdge] = 1;
+                int i = edges[deltaEdge].i, j = edges[deltaEdge].j;
+                if (label[inBlossom[i]] == 0) swap(i, j);
+                queue.push_back(i);
+            } else if (deltaType == 3) {
+                allowEdge[deltaEdge] = 1;
+                queue.push_back(edges[deltaEdge].i);
+            } else {
+                expandBlossom(deltaBlossom, false);
+            }
+        }
+        if (!augmented) break;
+
+        // Expand S-blossoms whose dual reached zero before the next stage
+        for (int b = n; b < 2 * n; ++b) {
+            if (blossomParent[b] == -1 && blossomBase[b] >= 0 && label[b] == 1 && dualVar[b] == 0.0)
+                expandBlossom(b, true);
+        }
+    }
+
+    vector<int> result(n, -1);
+    for (int v = 0; v < n; ++v)
+        if (mate[v] >= 0) result[v] = endpoint[mate[v]];
+    return result;
+}
+
+} // namespace
+
+vector<int> Matching::minWeightPerfectMatching(const vector<vector<double>>& cost) {
+    const int k = static_cast<int>(cost.size());
+    // Maximise (C - cost) over maximum-cardinality matchings: every perfect
+    // matching gains the same k/2 * C, so this minimises the total cost.
+    double maxCost = 0.0;
+    for (int i = 0; i < k; ++i)
+        for (int j = i + 1; j < k; ++j)
+            if (isfinite(cost[i][j])) maxCost = max(maxCost, cost[i][j]);
+    const double offset = maxCost + 1.0;
+
+    vector<BlossomMatcher::WeightedEdge> edges;
+    edges.reserve(static_cast<size_t>(k) * (k > 0 ? k - 1 : 0) / 2);
+    for (int i = 0; i < k; ++i)
+        for (int j = i + 1; j < k; ++j)
+            if (isfinite(cost[i][j])) edges.push_back({i, j, offset - cost[i][j]});
+
+    BlossomMatcher matcher(k, move(edges));
+    return matcher.solve();
+}
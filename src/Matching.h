@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+namespace Matching {
+
+// Exact minimum-weight perfect matching on the complete graph given by a
+// symmetric k x k cost matrix, using Edmonds' weighted blossom algorithm with
+// dual variables (O(k^3)). Pairs with a non-finite cost are treated as absent.
+// Returns mate[i] for every vertex, or -1 if the vertex could not be matched.
+std::vector<int> minWeightPerfectMatching(const std::vector<std::vector<double>>& cost);
+
+}
@@ -0,0 +1,358 @@
+#include "ShortestPath.h"
+#include "Graph.h"
+#include "ContractionHierarchy.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+void ShortestPath::dijkstra(const CsrGraph &g, int source, Workspace &ws, int target) {
+    if (target >= 0) {
+        dijkstraToTargets(g, source, ws, [target](int v) { return v == target; }, 1);
+    } else {
+        dijkstraToTargets(g, source, ws, [](int) { return false; }, numeric_limits<int>::max());
+    }
+}
+
+bool ShortestPath::batchedSearch(const CsrGraph &g, const int *sources, int count, BatchWorkspace &ws) {
+    constexpr int L = kBatchLanes;
+    const int n = g.vertexCount();
+    ws.dist.assign(static_cast<size_t>(n) * L, numeric_limits<double>::infinity());
+    ws.predEdge.assign(static_cast<size_t>(n) * L, -1);
+    ws.queued.assign(n, 0);
+    ws.heap.clear();
+    if (n == 0) return true;
+
+    using QN = pair<double, int>;
+    // Vertices are scanned in order of the mean of their reached lanes. With
+    // nearby sources in one batch the lanes rise almost together, so few scans
+    // are repeated (about 2 per vertex and batch on road-like grids, against 3
+    // keyed by the smallest lane); any order converges to exact distances.
+    auto enqueue = [&](int v, double key) {
+        ws.queued[v] = 1;
+        ws.heap.emplace_back(key, v);
+        push_heap(ws.heap.begin(), ws.heap.end(), greater<QN>());
+    };
+    for (int lane = 0; lane < count && lane < L; ++lane) {
+        int s = sources[lane];
+        if (s < 0 || s >= n) continue;
+        ws.dist[static_cast<size_t>(s) * L + lane] = 0.0;
+        if (!ws.queued[s]) enqueue(s, 0.0);
+    }
+
+    alignas(16) double base[L];
+    // far-apart sources re-scan without bound; give up well before that costs
+    // more than the per-source searches would
+    long long scansLeft = static_cast<long long>(kBatchMaxScansPerVertex) * n;
+    while (!ws.heap.empty()) {
+        pop_heap(ws.heap.begin(), ws.heap.end(), greater<QN>());
+        const int u = ws.heap.back().second;
+        ws.heap.pop_back();
+        if (!ws.queued[u]) continue; // scanned since this entry was queued
+        if (--scansLeft < 0) return false;
+        ws.queued[u] = 0;
+        const double *du = &ws.dist[static_cast<size_t>(u) * L];
+        for (int l = 0; l < L; ++l) base[l] = du[l];
+        for (int a = g.arcBegin(u); a < g.arcEnd(u); ++a) {
+            const int v = g.target(a);
+            const double w = g.weight(a);
+            const int eid = g.edgeId(a);
+            double *dv = &ws.dist[static_cast<size_t>(v) * L];
+            // most arcs improve no lane: test all lanes first, store only on a hit
+            alignas(16) double nd[L];
+            int improved = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            const __m128d wide = _mm_set1_pd(w);
+            for (int l = 0; l < L; l += 2) {
+                const __m128d cand = _mm_add_pd(_mm_load_pd(base + l), wide);
+                _mm_store_pd(nd + l, cand);
+                improved |= _mm_movemask_pd(_mm_cmplt_pd(cand, _mm_loadu_pd(dv + l)));
+            }
+#else
+            for (int l = 0; l < L; ++l) {
+                nd[l] = base[l] + w;
+                improved |= nd[l] < dv[l];
+            }
+#endif
+            if (!improved) continue;
+            int *pv = &ws.predEdge[static_cast<size_t>(v) * L];
+            double sum = 0.0;
+            int reached = 0;
+            for (int l = 0; l < L; ++l) {
+                const bool better = nd[l] < dv[l];
+                dv[l] = better ? nd[l] : dv[l];
+                pv[l] = better ? eid : pv[l];
+                if (dv[l] < numeric_limits<double>::infinity()) { sum += dv[l]; ++reached; }
+            }
+            enqueue(v, sum / reached);
+        }
+    }
+    return true;
+}
+
+namespace {
+template <typename PredOf>
+void collectPaths(PredOf pred, size_t vertexCount, const vector<Edge> &edges, int source, const int *targets,
+                  int count, vector<char> &marked, ShortestPath::SparseTree &tree) {
+    tree.clear();
+    if (marked.size() < vertexCount) marked.assign(vertexCount, 0);
+    for (int t = 0; t < count; ++t) {
+        for (int v = targets[t]; v != source && !marked[v]; ) {
+            const int eid = pred(v);
+            if (eid < 0) break;
+            marked[v] = 1;
+            tree.emplace_back(v, eid);
+            const Edge &e = edges[eid];
+            v = (e.u == v) ? e.v : e.u;
+        }
+    }
+    for (const auto &entry : tree) marked[entry.first] = 0;
+    sort(tree.begin(), tree.end());
+    tree.shrink_to_fit();
+}
+}
+
+void ShortestPath::keepPaths(Workspace &ws, const vector<Edge> &edges, int source, const int *targets, int count,
+                             SparseTree &tree) {
+    const vector<int> &predEdge = ws.predEdge;
+    collectPaths([&predEdge](int v) { return predEdge[v]; }, predEdge.size(), edges, source, targets, count,
+                 ws.marked, tree);
+}
+
+void ShortestPath::BatchWorkspace::keepPaths(int lane, const vector<Edge> &edges, int source, const int *targets,
+                                             int count, SparseTree &tree) {
+    collectPaths([this, lane](int v) { return predEdge[static_cast<size_t>(v) * kBatchLanes + lane]; },
+                 predEdge.size() / kBatchLanes, edges, source, targets, count, marked, tree);
+}
+
+vector<int> ShortestPath::pathEdges(const vector<int> &predEdge, const vector<Edge> &edges, int source, int target) {
+    vector<int> path;
+    for (int v = target; v != source; ) {
+        int eid = predEdge[v];
+        if (eid < 0) return {};
+        path.push_back(eid);
+        const Edge &e = edges[eid];
+        v = (e.u == v) ? e.v : e.u;
+    }
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+vector<int> ShortestPath::pathEdges(const SparseTree &tree, const vector<Edge> &edges, int source, int target) {
+    vector<int> path;
+    for (int v = target; v != source; ) {
+        auto it = lower_bound(tree.begin(), tree.end(), make_pair(v, numeric_limits<int>::min()));
+        if (it == tree.end() || it->first != v) return {};
+        path.push_back(it->second);
+        const Edge &e = edges[it->second];
+        v = (e.u == v) ? e.v : e.u;
+    }
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+vector<int> ShortestPath::pathVertices(const vector<int> &predEdge, const vector<Edge> &edges, int source, int target) {
+    vector<int> path{target};
+    for (int v = target; v != source; ) {
+        int eid = predEdge[v];
+        if (eid < 0) return {};
+        const Edge &e = edges[eid];
+        v = (e.u == v) ? e.v : e.u;
+        path.push_back(v);
+    }
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+ShortestPath::DistanceOracle::DistanceOracle(const Graph &g) : graph(g) {}
+
+const ShortestPath::DistanceOracle::Tree &ShortestPath::DistanceOracle::treeFor(int source, int target, bool &reversed) {
+    reversed = false;
+    auto it = trees.find(source);
+    if (it != trees.end()) return it->second;
+    it = trees.find(target);
+    if (it != trees.end()) { reversed = true; return it->second; }
+
+    dijkstra(graph.csr(), source, ws);
+    Tree &tree = trees[source];
+    tree.dist = ws.dist;
+    tree.predEdge = ws.predEdge;
+    return tree;
+}
+
+double ShortestPath::DistanceOracle::distance(int source, int target) {
+    bool reversed = false;
+    const Tree &tree = treeFor(source, target, reversed);
+    return tree.dist[reversed ? source : target];
+}
+
+ShortestPath::Route ShortestPath::DistanceOracle::route(int source, int target) {
+    bool reversed = false;
+    const Tree &tree = treeFor(source, target, reversed);
+    Route r;
+    int root = reversed ? target : source;
+    int leaf = reversed ? source : target;
+    r.length = tree.dist[leaf];
+    r.edges = pathEdges(tree.predEdge, graph.getEdges(), root, leaf);
+    if (reversed) reverse(r.edges.begin(), r.edges.end());
+    return r;
+}
+
+double ShortestPath::euclideanScale(const Graph &graph) {
+    const auto &verts = graph.getVertices();
+    double scale = numeric_limits<double>::infinity();
+    for (const auto &e : graph.liveEdges()) {
+        const QPointF p = verts[e.u].position;
+        const QPointF q = verts[e.v].position;
+        double len = hypot(p.x() - q.x(), p.y() - q.y());
+        if (len <= 0.0) continue;
+        scale = min(scale, max(0.0, static_cast<double>(e.weight)) / len);
+    }
+    return isfinite(scale) ? scale : 0.0;
+}
+
+ShortestPath::PointToPoint::PointToPoint(const Graph &g) : graph(g), scale(euclideanScale(g)) {}
+
+ShortestPath::Engine ShortestPath::PointToPoint::preferred() const {
+    if (graph.contractionHierarchy()) return Engine::Hierarchy;
+    return scale > 0.0 ? Engine::AStar : Engine::Bidirectional;
+}
+
+ShortestPath::Route ShortestPath::PointToPoint::query(int source, int target, Engine engine) {
+    settledCount = 0;
+    const int n = graph.csr().vertexCount();
+    if (source < 0 || target < 0 || source >= n || target >= n) return {};
+    switch (engine) {
+    case Engine::Hierarchy:
+        if (const ContractionHierarchy *ch = graph.contractionHierarchy()) return ch->route(source, target, &settledCount);
+        return bidirectional(source, target);
+    case Engine::Bidirectional: return bidirectional(source, target);
+    case Engine::AStar: return aStar(source, target, scale);
+    case Engine::Dijkstra: break;
+    }
+    return aStar(source, target, 0.0); // a zero heuristic is plain Dijkstra
+}
+
+ShortestPath::Route ShortestPath::PointToPoint::aStar(int source, int target, double heuristicScale) {
+    const CsrGraph &g = graph.csr();
+    const auto &verts = graph.getVertices();
+    const QPointF goal = verts[target].position;
+    auto h = [&](int v) {
+        if (heuristicScale == 0.0) return 0.0;
+        const QPointF p = verts[v].position;
+        return heuristicScale * hypot(p.x() - goal.x(), p.y() - goal.y());
+    };
+
+    auto &dist = forward.dist;
+    auto &predEdge = forward.predEdge;
+    auto &heap = forward.heap; // keyed by dist + h
+    dist.assign(g.vertexCount(), numeric_limits<double>::infinity());
+    predEdge.assign(g.vertexCount(), -1);
+    closedForward.assign(g.vertexCount(), 0);
+    heap.clear();
+
+    using QN = pair<double, int>;
+    dist[source] = 0.0;
+    heap.emplace_back(h(source), source);
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), greater<QN>());
+        int u = heap.back().second; heap.pop_back();
+        if (closedForward[u]) continue;
+        closedForward[u] = 1; // consistent heuristic: settled once, exactly
+        ++settledCount;
+        if (u == target) break;
+        for (int a = g.arcBegin(u); a < g.arcEnd(u); ++a) {
+            int v = g.target(a);
+            double nd = dist[u] + g.weight(a);
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                predEdge[v] = g.edgeId(a);
+                heap.emplace_back(nd + h(v), v);
+                push_heap(heap.begin(), heap.end(), greater<QN>());
+            }
+        }
+    }
+
+    Route r;
+    if (!closedForward[target]) return r;
+    r.length = dist[target];
+    r.edges = pathEdges(predEdge, graph.getEdges(), source, target);
+    return r;
+}
+
+ShortestPath::Route ShortestPath::PointToPoint::bidirectional(int source, int target) {
+    const CsrGraph &g = graph.csr();
+    const int n = g.vertexCount();
+    using QN = pair<double, int>;
+    const double inf = numeric_limits<double>::infinity();
+    Workspace *side[2] = {&forward, &backward};
+    vector<char> *closed[2] = {&closedForward, &closedBackward};
+    for (int k = 0; k < 2; ++k) {
+        side[k]->dist.assign(n, inf);
+        side[k]->predEdge.assign(n, -1);
+        side[k]->heap.clear();
+        closed[k]->assign(n, 0);
+    }
+    forward.dist[source] = 0.0;
+    forward.heap.emplace_back(0.0, source);
+    backward.dist[target] = 0.0;
+    backward.heap.emplace_back(0.0, target);
+
+    // best source-target length seen so far, and the edge joining both trees
+    double best = (source == target) ? 0.0 : inf;
+    int meetEdge = -1, meetSide = 0, meetFrom = -1, meetTo = -1;
+
+    auto cleanTop = [&](Workspace &ws) {
+        while (!ws.heap.empty() && ws.heap.front().first > ws.dist[ws.heap.front().second]) {
+            pop_heap(ws.heap.begin(), ws.heap.end(), greater<QN>());
+            ws.heap.pop_back();
+        }
+    };
+    while (true) {
+        cleanTop(forward);
+        cleanTop(backward);
+        if (forward.heap.empty() || backward.heap.empty()) break;
+        // no undiscovered path can beat best once both frontiers pass it
+        if (forward.heap.front().first + backward.heap.front().first >= best) break;
+
+        int k = (forward.heap.front().first <= backward.heap.front().first) ? 0 : 1;
+        Workspace &ws = *side[k];
+        const Workspace &other = *side[1 - k];
+        pop_heap(ws.heap.begin(), ws.heap.end(), greater<QN>());
+        auto [d, u] = ws.heap.back(); ws.heap.pop_back();
+        if ((*closed[k])[u]) continue;
+        (*closed[k])[u] = 1;
+        ++settledCount;
+        for (int a = g.arcBegin(u); a < g.arcEnd(u); ++a) {
+            int v = g.target(a);
+            double nd = d + g.weight(a);
+            if (nd < ws.dist[v]) {
+                ws.dist[v] = nd;
+                ws.predEdge[v] = g.edgeId(a);
+                ws.heap.emplace_back(nd, v);
+                push_heap(ws.heap.begin(), ws.heap.end(), greater<QN>());
+            }
+            if (other.dist[v] < inf && nd + other.dist[v] < best) {
+                best = nd + other.dist[v];
+                meetEdge = g.edgeId(a); meetSide = k; meetFrom = u; meetTo = v;
+            }
+        }
+    }
+
+    Route r;
+    if (best == inf) return r;
+    r.length = best;
+    if (meetEdge < 0) return r; // source == target
+    const auto &edges = graph.getEdges();
+    // forward tree reaches the forward endpoint; backward tree runs from target
+    int forwardEnd = meetSide == 0 ? meetFrom : meetTo;
+    int backwardEnd = meetSide == 0 ? meetTo : meetFrom;
+    r.edges = pathEdges(forward.predEdge, edges, source, forwardEnd);
+    r.edges.push_back(meetEdge);
+    vector<int> tail = pathEdges(backward.predEdge, edges, target, backwardEnd);
+    r.edges.insert(r.edges.end(), tail.rbegin(), tail.rend());
+    return r;
+}
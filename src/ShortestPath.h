@@ -0,0 +1,357 @@
+#pragma once
+
+#include "CsrGraph.h"
+#include <QtCore/qalgorithms.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+
+struct Edge;
+class Graph;
+
+namespace ShortestPath {
+
+// Priority queues for the label-setting loop. All of them hand out entries in
+// non-decreasing key order with lazy deletion: a vertex may be queued several
+// times and the search skips entries whose key exceeds its settled distance.
+// Key is the weight type the search runs on.
+
+// Binary min-heap over a borrowed vector, for arbitrary double weights.
+class BinaryHeapQueue {
+public:
+    using Key = double;
+    explicit BinaryHeapQueue(std::vector<std::pair<double, int>> &storage) : heap(storage) { heap.clear(); }
+    bool empty() const { return heap.empty(); }
+    void push(Key key, int v) {
+        heap.emplace_back(key, v);
+        std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<double, int>>());
+    }
+    std::pair<Key, int> pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<double, int>>());
+        auto top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+
+private:
+    std::vector<std::pair<double, int>> &heap;
+};
+
+// Dial's bucket queue for integer weights up to maxWeight: live keys always lie
+// in [current, current + maxWeight], so maxWeight + 1 circular buckets hold
+// them without collisions. O(1) push and amortised O(1) pop plus one step per
+// unit of distance, which pays off when the largest weight is small. reset()
+// clears only the buckets an early-stopped search left filled.
+template <typename Weight>
+class DialQueue {
+    static_assert(std::is_unsigned<Weight>::value, "DialQueue needs unsigned integer weights");
+
+public:
+    using Key = Weight;
+    void reset(Key maxWeight) {
+        // entries left over all have keys in [current, top]
+        if (count > 0) {
+            const Key span = std::min<Key>(top - current, static_cast<Key>(buckets.size() - 1));
+            for (Key k = current; k <= current + span; ++k) buckets[static_cast<size_t>(k % buckets.size())].clear();
+        }
+        buckets.resize(static_cast<size_t>(maxWeight) + 1);
+        current = 0;
+        top = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    void push(Key key, int v) {
+        buckets[static_cast<size_t>(key % buckets.size())].push_back(v);
+        top = std::max(top, key);
+        ++count;
+    }
+    std::pair<Key, int> pop() {
+        while (buckets[static_cast<size_t>(current % buckets.size())].empty()) ++current;
+        auto &b = buckets[static_cast<size_t>(current % buckets.size())];
+        int v = b.back();
+        b.pop_back();
+        --count;
+        return {current, v};
+    }
+
+private:
+    std::vector<std::vector<int>> buckets;
+    Key current{0};
+    Key top{0}; // largest key pushed since reset()
+    size_t count{0};
+};
+
+// Radix heap for integer weights of any size: an entry lives in the bucket of
+// the highest bit in which its key differs from the last key popped, and a
+// bucket is redistributed only when everything below it is empty, so every
+// entry moves at most once per bit (O(log C) amortised per push).
+template <typename Weight>
+class RadixHeapQueue {
+    static_assert(std::is_unsigned<Weight>::value, "RadixHeapQueue needs unsigned integer weights");
+
+public:
+    using Key = Weight;
+    void reset() {
+        for (auto &b : buckets) b.clear();
+        last = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    void push(Key key, int v) {
+        buckets[bucketOf(key)].emplace_back(key, v);
+        ++count;
+    }
+    std::pair<Key, int> pop() {
+        if (buckets[0].empty()) {
+            size_t i = 1;
+            while (buckets[i].empty()) ++i;
+            last = std::min_element(buckets[i].begin(), buckets[i].end())->first;
+            for (const auto &entry : buckets[i]) buckets[bucketOf(entry.first)].push_back(entry);
+            buckets[i].clear();
+        }
+        auto top = buckets[0].back();
+        buckets[0].pop_back();
+        --count;
+        return top;
+    }
+
+private:
+    static constexpr int kBits = std::numeric_limits<Key>::digits;
+    std::array<std::vector<std::pair<Key, int>>, kBits + 1> buckets;
+    Key last{0};
+    size_t count{0};
+
+    size_t bucketOf(Key key) const {
+        return key == last ? 0 : static_cast<size_t>(64 - qCountLeadingZeroBits(static_cast<quint64>(key ^ last)));
+    }
+};
+
+// Which queue a search over g runs on, from the CSR weight profile: integer
+// weights use Dial when the heaviest edge is light, otherwise a radix heap;
+// anything else (fractional weights) keeps the binary heap. Dial's pops step
+// through every distance value up to the farthest one settled, about hops *
+// maxWeight, so it needs maxWeight small in absolute terms and next to V.
+enum class QueueKind { BinaryHeap, Dial, Radix };
+constexpr double kDialMaxWeight = 255;
+inline QueueKind queueFor(const CsrGraph &g) {
+    if (!g.integerWeights()) return QueueKind::BinaryHeap;
+    const bool light = g.maxWeight() <= kDialMaxWeight && g.maxWeight() < g.vertexCount();
+    return light ? QueueKind::Dial : QueueKind::Radix;
+}
+
+// The part of a predecessor-edge tree on the paths from its source to a few
+// chosen targets, as (vertex, edge id) pairs sorted by vertex. Keeping one per
+// source costs the size of those paths instead of a V-sized array.
+using SparseTree = std::vector<std::pair<int, int>>;
+
+// Per-thread scratch reused across single-source searches. After a search,
+// predEdge[v] is the id of the edge through which v was reached (-1 for the
+// source and unreached vertices), so paths expand in O(length) without
+// scanning adjacency lists.
+struct Workspace {
+    std::vector<double> dist;
+    std::vector<int> predEdge;
+    std::vector<std::pair<double, int>> heap; // binary min-heap with lazy deletion
+    DialQueue<std::uint64_t> dial;
+    RadixHeapQueue<std::uint64_t> radix;
+    std::vector<char> marked; // scratch for keepPaths
+};
+
+// Dijkstra from source over the CSR view. Stops early once target is settled
+// when target >= 0; otherwise settles every reachable vertex. The queue is
+// picked by queueFor(g).
+void dijkstra(const CsrGraph &g, int source, Workspace &ws, int target = -1);
+
+// Multi-target Dijkstra: settles vertices in distance order and stops as soon
+// as `targets` vertices with isTarget(v) have been settled, or when the next
+// vertex lies farther than radius (k-nearest candidate queries). dist and
+// predEdge are exact for settled vertices; anything else is an upper bound, but
+// every vertex with dist <= radius is settled. Returns the targets settled.
+template <typename IsTarget>
+int dijkstraToTargets(const CsrGraph &g, int source, Workspace &ws, IsTarget isTarget, int targets,
+                      double radius = std::numeric_limits<double>::infinity());
+
+// Batched label-correcting search: up to kBatchLanes sources share every
+// adjacency scan. Each vertex stores one distance and one predecessor edge per
+// source in adjacent lanes, and relaxing an arc tests all lanes with SSE2
+// compares (a plain lane loop elsewhere) before storing anything. Vertices whose
+// lanes improve are re-queued (label-correcting), so a vertex may be scanned
+// more than once; this pays off when many sources need full trees.
+constexpr int kBatchLanes = 8;
+// A batch gives up after this many scans per vertex on average (about 2 are
+// typical for nearby sources), leaving the caller to search per source.
+constexpr int kBatchMaxScansPerVertex = 6;
+
+struct BatchWorkspace {
+    std::vector<double> dist;  // dist[v * kBatchLanes + lane]
+    std::vector<int> predEdge; // same layout
+    std::vector<std::pair<double, int>> heap; // keyed by the mean reached lane
+    std::vector<char> queued;
+    std::vector<char> marked; // scratch for keepPaths
+
+    // memory held per graph vertex once a search has run
+    static constexpr size_t bytesPerVertex = kBatchLanes * (sizeof(double) + sizeof(int)) + 2 * sizeof(char);
+
+    double distance(int lane, int v) const { return dist[static_cast<size_t>(v) * kBatchLanes + lane]; }
+    // keepPaths (below) for the tree of lane, whose source is source.
+    void keepPaths(int lane, const std::vector<Edge> &edges, int source, const int *targets, int count,
+                   SparseTree &tree);
+};
+
+// Exact distances and predecessor edges from sources[0..count), count <=
+// kBatchLanes; unused lanes stay at infinity. Weights must be non-negative.
+// False, with ws holding only upper bounds, if the search would exceed
+// kBatchMaxScansPerVertex scans per vertex.
+bool batchedSearch(const CsrGraph &g, const int *sources, int count, BatchWorkspace &ws);
+
+// Edge ids of the source -> target path stored in a predecessor-edge tree,
+// in travel order. Empty if target is unreachable or equal to source.
+std::vector<int> pathEdges(const std::vector<int> &predEdge, const std::vector<Edge> &edges, int source, int target);
+// The same for a sparse tree, whose lookups are binary searches.
+std::vector<int> pathEdges(const SparseTree &tree, const std::vector<Edge> &edges, int source, int target);
+
+// Fills tree with the paths from source to targets[0..count) held in
+// ws.predEdge after a search from source, walking back from each target until
+// it meets a vertex already kept: O(size of the result). Unreachable targets
+// are left out.
+void keepPaths(Workspace &ws, const std::vector<Edge> &edges, int source, const int *targets, int count,
+               SparseTree &tree);
+
+// Vertex sequence (source ... target) of the same path; empty if unreachable.
+std::vector<int> pathVertices(const std::vector<int> &predEdge, const std::vector<Edge> &edges, int source, int target);
+
+// Length and edge ids of a shortest path; length is infinity when unreachable.
+struct Route {
+    double length{std::numeric_limits<double>::infinity()};
+    std::vector<int> edges;
+};
+
+// Memoizing distance oracle over one graph snapshot: the first query from a
+// source runs a full Dijkstra and keeps its distance/predecessor-edge tree, and
+// later queries touching that source (from either end, the graph being
+// undirected) are answered from the cache. The graph must outlive the oracle
+// and stay unmodified while it is used.
+class DistanceOracle {
+public:
+    explicit DistanceOracle(const Graph &graph);
+
+    double distance(int source, int target);
+    Route route(int source, int target);
+    int cachedSources() const { return static_cast<int>(trees.size()); }
+
+private:
+    struct Tree {
+        std::vector<double> dist;
+        std::vector<int> predEdge;
+    };
+
+    const Graph &graph;
+    Workspace ws;
+    std::unordered_map<int, Tree> trees;
+
+    // cached tree rooted at source or target (building one for source if neither
+    // is cached); sets reversed when the tree is rooted at target
+    const Tree &treeFor(int source, int target, bool &reversed);
+};
+
+// Point-to-point search engines.
+enum class Engine {
+    Dijkstra,      // unidirectional, stops at the target
+    Bidirectional, // forward and backward Dijkstra meeting in the middle
+    AStar,         // goal-directed by an admissible Euclidean heuristic
+    Hierarchy      // contraction-hierarchy index attached to the graph;
+                   // falls back to Bidirectional when none is attached
+};
+
+// Smallest weight per unit of straight-line length over all edges, so that
+// scale * |position(v) - position(t)| never overestimates the remaining
+// distance. 0 if a positive-length edge is free (A* then behaves as Dijkstra).
+double euclideanScale(const Graph &graph);
+
+// Reusable point-to-point searcher for interactive queries. The heuristic
+// scale is calibrated once on construction (O(E)); build a new searcher after
+// vertices move or edges change.
+class PointToPoint {
+public:
+    explicit PointToPoint(const Graph &graph);
+
+    Route query(int source, int target, Engine engine);
+    // Engine for interactive queries: Hierarchy when an index is attached,
+    // else A* when the positions give a nonzero heuristic, else Bidirectional.
+    Engine preferred() const;
+    // vertices settled by the last query, i.e. how much of the graph it touched
+    int lastSettled() const { return settledCount; }
+
+private:
+    const Graph &graph;
+    double scale;
+    Workspace forward, backward;
+    std::vector<char> closedForward, closedBackward;
+    int settledCount{0};
+
+    Route aStar(int source, int target, double heuristicScale);
+    Route bidirectional(int source, int target);
+};
+
+}
+
+namespace ShortestPath::detail {
+
+// Label-setting loop shared by all queues; arc weights are read as Queue::Key,
+// so integer queues add exact integers. dist/predEdge must already be reset.
+template <typename Queue, typename IsTarget>
+int settle(const CsrGraph &g, int source, Workspace &ws, Queue &queue, IsTarget isTarget, int targets, double radius) {
+    using Key = typename Queue::Key;
+    auto &dist = ws.dist;
+    auto &predEdge = ws.predEdge;
+    int settled = 0;
+    dist[source] = 0.0;
+    queue.push(Key(0), source);
+    while (!queue.empty()) {
+        auto [k, u] = queue.pop();
+        const double d = static_cast<double>(k);
+        if (d > dist[u]) continue;
+        if (d > radius) break;
+        if (isTarget(u) && ++settled == targets) break;
+        for (int a = g.arcBegin(u); a < g.arcEnd(u); ++a) {
+            int v = g.target(a);
+            const Key nk = k + static_cast<Key>(g.weight(a));
+            const double nd = static_cast<double>(nk);
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                predEdge[v] = g.edgeId(a);
+                queue.push(nk, v);
+            }
+        }
+    }
+    return settled;
+}
+
+}
+
+template <typename IsTarget>
+int ShortestPath::dijkstraToTargets(const CsrGraph &g, int source, Workspace &ws, IsTarget isTarget, int targets,
+                                    double radius) {
+    ws.dist.assign(g.vertexCount(), std::numeric_limits<double>::infinity());
+    ws.predEdge.assign(g.vertexCount(), -1);
+    if (source < 0 || source >= g.vertexCount() || targets <= 0) return 0;
+
+    switch (queueFor(g)) {
+    case QueueKind::Dial:
+        ws.dial.reset(static_cast<std::uint64_t>(g.maxWeight()));
+        return detail::settle(g, source, ws, ws.dial, isTarget, targets, radius);
+    case QueueKind::Radix:
+        ws.radix.reset();
+        return detail::settle(g, source, ws, ws.radix, isTarget, targets, radius);
+    case QueueKind::BinaryHeap:
+        break;
+    }
+    BinaryHeapQueue heap(ws.heap);
+    return detail::settle(g, source, ws, heap, isTarget, targets, radius);
+}
@@ -0,0 +1,67 @@
+#include "StrongComponents.h"
+#include "CsrGraph.h"
+#include "Graph.h"
+#include <algorithm>
+
+int StrongComponents::compute(const Graph &graph, std::vector<int> &componentOf, Workspace &ws) {
+    const CsrGraph &g = graph.csr();
+    const std::vector<Edge> &edges = graph.getEdges();
+    const int n = g.vertexCount();
+    componentOf.assign(n, -1);
+    ws.index.assign(n, -1);
+    ws.low.resize(n);
+    ws.onStack.assign(n, 0);
+    ws.pending.clear();
+    ws.path.clear();
+
+    // the CSR lists every edge at both ends; a directed edge only leaves its tail
+    auto leaves = [&](int arc, int from) {
+        const Edge &e = edges[g.edgeId(arc)];
+        return !e.directed || e.u == from;
+    };
+
+    int counter = 0;
+    int components = 0;
+    for (int root = 0; root < n; ++root) {
+        if (!graph.hasVertex(root) || ws.index[root] >= 0) continue;
+        ws.index[root] = ws.low[root] = counter++;
+        ws.pending.push_back(root);
+        ws.onStack[root] = 1;
+        ws.path.emplace_back(root, g.arcBegin(root));
+        while (!ws.path.empty()) {
+            const int v = ws.path.back().first;
+            int &arc = ws.path.back().second;
+            if (arc < g.arcEnd(v)) {
+                const int a = arc++;
+                if (!leaves(a, v)) continue;
+                const int w = g.target(a);
+                if (ws.index[w] < 0) {
+                    ws.index[w] = ws.low[w] = counter++;
+                    ws.pending.push_back(w);
+                    ws.onStack[w] = 1;
+                    ws.path.emplace_back(w, g.arcBegin(w)); // invalidates arc
+                } else if (ws.onStack[w]) {
+                    ws.low[v] = std::min(ws.low[v], ws.index[w]);
+                }
+                continue;
+            }
+            // v is finished: it roots a component when nothing below reached higher
+            ws.path.pop_back();
+            if (ws.low[v] == ws.index[v]) {
+                int w;
+                do {
+                    w = ws.pending.back();
+                    ws.pending.pop_back();
+                    ws.onStack[w] = 0;
+                    componentOf[w] = components;
+                } while (w != v);
+                ++components;
+            }
+            if (!ws.path.empty()) {
+                const int parent = ws.path.back().first;
+                ws.low[parent] = std::min(ws.low[parent], ws.low[v]);
+            }
+        }
+    }
+    return components;
+}
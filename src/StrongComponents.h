@@ -0,0 +1,27 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+class Graph;
+
+namespace StrongComponents {
+
+// Scratch arrays for compute(), kept between calls so repeated checks on the
+// same graph allocate nothing once they have grown to size.
+struct Workspace {
+    std::vector<int> index;                // discovery order, -1 = unvisited
+    std::vector<int> low;                  // lowest index reachable from the subtree
+    std::vector<int> pending;              // Tarjan's stack of unassigned vertices
+    std::vector<char> onStack;
+    std::vector<std::pair<int, int>> path; // explicit DFS frames: (vertex, next arc)
+};
+
+// Tarjan's strongly connected components, iterative so long one-way chains
+// cannot overflow the call stack. Undirected edges run both ways, directed
+// ones only from u to v. Fills componentOf (indexed by vertex id, -1 for
+// removed vertices) with ids numbered in reverse topological order of the
+// condensation and returns the component count. O(V+E).
+int compute(const Graph &graph, std::vector<int> &componentOf, Workspace &ws);
+
+}
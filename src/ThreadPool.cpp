@@ -0,0 +1,105 @@
+#include "ThreadPool.h"
+
+namespace {
+thread_local bool insidePoolTask = false;
+}
+
+ThreadPool::ThreadPool(int threadCount) {
+    if (threadCount <= 0) threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    if (threadCount <= 0) threadCount = 1;
+    for (int i = 0; i < threadCount; ++i) queues.push_back(std::make_unique<TaskQueue>());
+    for (int i = 1; i < threadCount; ++i) threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto &t : threads) t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)>& body) {
+    if (count <= 0) return;
+    if (count == 1 || threads.empty() || insidePoolTask) {
+        for (int i = 0; i < count; ++i) body(i, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> call(callMutex);
+    // Seed each worker with a contiguous block so neighbouring indices stay together
+    const int workers = workerCount();
+    for (int w = 0; w < workers; ++w) {
+        int begin = static_cast<int>(static_cast<long long>(count) * w / workers);
+        int end = static_cast<int>(static_cast<long long>(count) * (w + 1) / workers);
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (int i = begin; i < end; ++i) queues[w]->tasks.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        job = &body;
+        busyWorkers = static_cast<int>(threads.size());
+        ++generation;
+    }
+    wakeWorkers.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    workersDone.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop(int worker) {
+    unsigned long long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeWorkers.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runTasks(worker);
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--busyWorkers == 0) workersDone.notify_all();
+        }
+    }
+}
+
+void ThreadPool::runTasks(int worker) {
+    insidePoolTask = true;
+    int task = 0;
+    while (popOrSteal(worker, task)) (*job)(task, worker);
+    insidePoolTask = false;
+}
+
+bool ThreadPool::popOrSteal(int worker, int &task) {
+    {
+        TaskQueue &own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Tasks never spawn tasks, so one empty sweep over all victims means we are done
+    const int workers = workerCount();
+    for (int k = 1; k < workers; ++k) {
+        TaskQueue &victim = *queues[(worker + k) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent work-stealing pool for independent, index-addressed tasks.
+// parallelFor seeds every worker with a contiguous block of indices; a worker
+// pops from the back of its own deque and steals from the front of others
+// once it runs dry. The calling thread takes part as worker 0, so per-thread
+// scratch buffers can be indexed by the worker id passed to the body.
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0); // 0 = std::thread::hardware_concurrency()
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool shared by the solvers.
+    static ThreadPool& shared();
+
+    int workerCount() const { return static_cast<int>(queues.size()); }
+
+    // Runs body(index, worker) for every index in [0, count) and blocks until
+    // all calls returned. Calls from inside a task run serially on that thread.
+    void parallelFor(int count, const std::function<void(int index, int worker)>& body);
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues; // one per worker, [0] is the caller
+    std::vector<std::thread> threads;
+
+    std::mutex callMutex; // serializes concurrent parallelFor callers
+    std::mutex stateMutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable workersDone;
+    const std::function<void(int, int)>* job{nullptr};
+    unsigned long long generation{0};
+    int busyWorkers{0};
+    bool stopping{false};
+
+    void workerLoop(int worker);
+    void runTasks(int worker);
+    bool popOrSteal(int worker, int &task);
+};
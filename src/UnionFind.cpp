@@ -0,0 +1,34 @@
+#include "UnionFind.h"
+#include <numeric>
+#include <utility>
+
+void UnionFind::reset(int n) {
+    parent.resize(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    rank.assign(n, 0);
+}
+
+int UnionFind::add() {
+    int id = size();
+    parent.push_back(id);
+    rank.push_back(0);
+    return id;
+}
+
+int UnionFind::find(int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]]; // path halving
+        x = parent[x];
+    }
+    return x;
+}
+
+int UnionFind::unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return -1;
+    if (rank[a] < rank[b]) std::swap(a, b);
+    parent[b] = a;
+    if (rank[a] == rank[b]) ++rank[a];
+    return a;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+// Disjoint-set forest over dense ids with union by rank and path halving, so
+// any sequence of m operations costs O(m α(n)). It only ever merges: callers
+// that delete must rebuild from scratch with reset().
+class UnionFind {
+public:
+    // n singleton sets 0..n-1
+    void reset(int n);
+    // Appends a singleton set and returns its id.
+    int add();
+
+    int find(int x);
+    // Merges the sets of a and b and returns the surviving root, or -1 when
+    // they were already in the same set.
+    int unite(int a, int b);
+
+    int size() const { return static_cast<int>(parent.size()); }
+
+private:
+    std::vector<int> parent;
+    std::vector<unsigned char> rank; // < 32 for any int-indexed forest
+};